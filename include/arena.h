@@ -0,0 +1,235 @@
+/// \file
+/// \brief definition of intersections::Arena and intersections::ArenaAllocator
+
+#ifndef INTERSECTIONS_ARENA_H
+#define INTERSECTIONS_ARENA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace intersections {
+    // monotonic memory resource which hands out memory from a list of blocks;
+    // memory is reclaimed all at once, by a Scope, by reset or on destruction,
+    // and retained blocks are reused by later allocations;
+    // warning: not thread-safe
+    class Arena {
+    public:
+        static constexpr std::size_t default_block_size = 64*1024;
+
+        // on destruction, reclaims everything allocated from arena since construction;
+        // a null arena is ignored
+        class Scope {
+        public:
+            explicit Scope(Arena* arena) noexcept
+                    :arena(arena),
+                     block_index(arena ? arena->block_index : 0),
+                     offset(arena ? arena->offset : 0)
+            {
+            }
+
+            Scope(Scope const&) = delete;
+
+            Scope& operator=(Scope const&) = delete;
+
+            ~Scope()
+            {
+                if (arena) {
+                    arena->block_index = block_index;
+                    arena->offset = offset;
+                }
+            }
+
+        private:
+            Arena* arena;
+            std::size_t block_index;
+            std::size_t offset;
+        };
+
+        explicit Arena(std::size_t const block_size = default_block_size)
+                :block_size(block_size)
+        {
+        }
+
+        Arena(Arena const&) = delete;
+
+        Arena& operator=(Arena const&) = delete;
+
+        void* allocate(std::size_t const size, std::size_t const alignment)
+        {
+            assert((alignment & (alignment-1))==0);
+
+            // take memory from the first retained block with room for it
+            for (; block_index<blocks.size(); ++block_index, offset = 0) {
+                auto const& block = blocks[block_index];
+                auto const aligned_offset = align(block.memory.get(), offset, alignment);
+                if (aligned_offset+size<=block.size) {
+                    offset = aligned_offset+size;
+                    num_allocated += size;
+                    return block.memory.get()+aligned_offset;
+                }
+            }
+
+            // or add a new block, doubling in size each time
+            auto const new_block_size = std::max(
+                    size+alignment, blocks.empty() ? block_size : blocks.back().size*2);
+            blocks.push_back(Block{std::unique_ptr<char[]>(new char[new_block_size]), new_block_size});
+            block_index = blocks.size()-1;
+            auto const aligned_offset = align(blocks.back().memory.get(), 0, alignment);
+            offset = aligned_offset+size;
+            num_allocated += size;
+            return blocks.back().memory.get()+aligned_offset;
+        }
+
+        // memory is only reclaimed in bulk
+        void deallocate(void*, std::size_t) noexcept
+        {
+        }
+
+        // reclaims all memory allocated from the arena;
+        // retained blocks are merged so that the same allocations will fit in one block next time
+        void reset()
+        {
+            if (blocks.size()>1) {
+                auto const total_size = capacity();
+                blocks.clear();
+                blocks.push_back(Block{std::unique_ptr<char[]>(new char[total_size]), total_size});
+            }
+
+            block_index = 0;
+            offset = 0;
+        }
+
+        // returns the number of bytes held by the arena
+        std::size_t capacity() const noexcept
+        {
+            auto total_size = std::size_t{0};
+            for (auto const& block : blocks) {
+                total_size += block.size;
+            }
+            return total_size;
+        }
+
+        // returns the number of bytes allocated from the arena since construction,
+        // including those which have since been reclaimed
+        std::size_t allocated() const noexcept
+        {
+            return num_allocated;
+        }
+
+    private:
+        // returns the first offset from offset at which memory within block is aligned to alignment
+        static std::size_t align(char const* block, std::size_t const offset, std::size_t const alignment) noexcept
+        {
+            auto const address = reinterpret_cast<std::uintptr_t>(block)+offset;
+            auto const aligned_address = (address+alignment-1) & ~std::uintptr_t(alignment-1);
+            return offset+std::size_t(aligned_address-address);
+        }
+
+        struct Block {
+            std::unique_ptr<char[]> memory;
+            std::size_t size;
+        };
+
+        std::size_t block_size;
+        std::vector<Block> blocks;
+
+        // the next allocation is attempted at offset within blocks[block_index]
+        std::size_t block_index = 0;
+        std::size_t offset = 0;
+
+        std::size_t num_allocated = 0;
+    };
+
+    // allocator which takes memory from an Arena or, if it has none, from the heap;
+    // like std::pmr::polymorphic_allocator, it is not propagated to copies of a container
+    // so that copies of results do not refer to an arena which may be reclaimed;
+    // memory is aligned to alignment, which may exceed the alignment of T
+    template<typename T, std::size_t alignment = alignof(T)>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = ArenaAllocator<U, alignment>;
+        };
+
+        ArenaAllocator() noexcept = default;
+
+        ArenaAllocator(Arena* arena) noexcept
+                :resource(arena)
+        {
+        }
+
+        template<typename U, std::size_t that_alignment>
+        ArenaAllocator(ArenaAllocator<U, that_alignment> const& that) noexcept
+                :resource(that.arena())
+        {
+        }
+
+        T* allocate(std::size_t const n)
+        {
+            if (resource) {
+                return static_cast<T*>(resource->allocate(n*sizeof(T), alignment));
+            }
+
+            if (alignment<=alignof(std::max_align_t)) {
+                return static_cast<T*>(::operator new(n*sizeof(T)));
+            }
+
+            // over-allocate and store the address of the allocation just before the aligned block
+            auto const allocation = static_cast<char*>(::operator new(n*sizeof(T)+alignment+sizeof(void*)));
+            auto const address = (reinterpret_cast<std::uintptr_t>(allocation)+sizeof(void*)+alignment-1)
+                                 & ~std::uintptr_t(alignment-1);
+            auto const aligned = reinterpret_cast<void**>(address);
+            aligned[-1] = allocation;
+            return static_cast<T*>(static_cast<void*>(aligned));
+        }
+
+        void deallocate(T* const p, std::size_t const n) noexcept
+        {
+            if (resource) {
+                resource->deallocate(p, n*sizeof(T));
+            }
+            else if (alignment<=alignof(std::max_align_t)) {
+                ::operator delete(p);
+            }
+            else {
+                ::operator delete(static_cast<void**>(static_cast<void*>(p))[-1]);
+            }
+        }
+
+        ArenaAllocator select_on_container_copy_construction() const noexcept
+        {
+            return ArenaAllocator();
+        }
+
+        Arena* arena() const noexcept
+        {
+            return resource;
+        }
+
+        friend bool operator==(ArenaAllocator const& lhs, ArenaAllocator const& rhs) noexcept
+        {
+            return lhs.arena()==rhs.arena();
+        }
+
+        friend bool operator!=(ArenaAllocator const& lhs, ArenaAllocator const& rhs) noexcept
+        {
+            return !(lhs==rhs);
+        }
+
+    private:
+        Arena* resource = nullptr;
+    };
+
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
+
+#endif //INTERSECTIONS_ARENA_H
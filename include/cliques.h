@@ -0,0 +1,28 @@
+/// \file
+/// \brief declaration of the memory budget of intersections::solve<Solution::cliques>
+
+#ifndef INTERSECTIONS_CLIQUES_H
+#define INTERSECTIONS_CLIQUES_H
+
+#include <intersections.h>
+
+#include <cstddef>
+
+namespace intersections {
+    // the most memory which solve<Solution::cliques> allocates for its bitsets;
+    // it throws std::length_error rather than exceed this
+    constexpr std::size_t max_cliques_bytes = std::size_t{1} << 28;
+
+    // returns the memory which solve<Solution::cliques> needs for the bitsets of rectangles:
+    // a row of the overlap matrix for each rectangle
+    // and two sets for each level of the enumeration, which is no deeper than max_depth(rectangles)
+    std::size_t cliques_bytes(Rectangles const& rectangles);
+
+    // true iff solve<Solution::cliques> can solve rectangles within max_cliques_bytes
+    inline bool cliques_fit(Rectangles const& rectangles)
+    {
+        return cliques_bytes(rectangles)<=max_cliques_bytes;
+    }
+}
+
+#endif //INTERSECTIONS_CLIQUES_H
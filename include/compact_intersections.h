@@ -0,0 +1,128 @@
+/// \file
+/// \brief definition of intersections::CompactIntersections and related functions
+
+#ifndef INTERSECTIONS_COMPACT_INTERSECTIONS_H
+#define INTERSECTIONS_COMPACT_INTERSECTIONS_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace intersections {
+    // compact alternative to Intersections;
+    // overlaps are stored in one array and their constituents are stored in another
+    // as indices into the input rectangles (compressed sparse row layout)
+    class CompactIntersections {
+    public:
+        using Index = std::uint32_t;
+
+        // the indices of the rectangles which produce a single overlap
+        struct Constituents {
+            Index const* first;
+            Index const* last;
+
+            constexpr auto begin() const noexcept { return first; }
+
+            constexpr auto end() const noexcept { return last; }
+
+            constexpr auto size() const noexcept { return std::size_t(last-first); }
+        };
+
+        auto empty() const noexcept
+        {
+            return overlaps.empty();
+        }
+
+        auto size() const noexcept
+        {
+            return overlaps.size();
+        }
+
+        // returns the nth area of overlap
+        Rectangle const& overlap(std::size_t n) const noexcept
+        {
+            assert(n<size());
+            return overlaps[n];
+        }
+
+        // returns the indices of the rectangles which produce the nth area of overlap
+        Constituents constituents(std::size_t n) const noexcept
+        {
+            assert(n<size());
+            auto const data = indices.data();
+            return Constituents{data+offsets[n], data+offsets[n+1]};
+        }
+
+        void clear() noexcept
+        {
+            overlaps.clear();
+            offsets.resize(1);
+            indices.clear();
+        }
+
+        // add an overlap whose constituents point into the sequence beginning at first
+        void push_back(Rectangle const& overlap, RectangleSequence const& constituents, Rectangle const* first)
+        {
+            overlaps.push_back(overlap);
+            for (auto const constituent : constituents) {
+                auto const index = constituent-first;
+                assert(index>=0 && index<=std::numeric_limits<Index>::max());
+                indices.push_back(Index(index));
+            }
+            offsets.push_back(indices.size());
+        }
+
+    private:
+        std::vector<Rectangle> overlaps;
+
+        // offsets[n] and offsets[n+1] delimit the constituents of overlaps[n] in indices
+        std::vector<std::size_t> offsets = std::vector<std::size_t>(1, 0);
+        std::vector<Index> indices;
+    };
+
+    // given a set of rectangles, append the areas of overlap and the indices of the rectangles which overlap;
+    // working memory is allocated from arena and reclaimed on return
+    template<Solution solution>
+    void solve(Rectangles const& rectangles, CompactIntersections& output, Arena& arena)
+    {
+        assert(rectangles.size()<=std::numeric_limits<CompactIntersections::Index>::max());
+
+        auto const first = rectangles.data();
+        solve<solution>(
+                rectangles, [&output, first](Rectangle const& overlap, RectangleSequence const& constituents) {
+                    output.push_back(overlap, constituents, first);
+                }, arena);
+    }
+
+    // given a set of rectangles, append the areas of overlap and the indices of the rectangles which overlap
+    template<Solution solution>
+    void solve(Rectangles const& rectangles, CompactIntersections& output)
+    {
+        Arena arena;
+        solve<solution>(rectangles, output, arena);
+    }
+
+    // convert compact results into the equivalent map;
+    // warning: returns non-owning pointers to rectangles
+    inline Intersections to_intersections(CompactIntersections const& compact, Rectangles const& rectangles)
+    {
+        Intersections intersections;
+        for (auto n = std::size_t{0}; n!=compact.size(); ++n) {
+            auto const constituents = compact.constituents(n);
+
+            RectangleSequence sequence;
+            sequence.reserve(constituents.size());
+            for (auto const index : constituents) {
+                sequence.push_back(&rectangles[index]);
+            }
+
+            intersections.emplace(compact.overlap(n), std::move(sequence));
+        }
+        return intersections;
+    }
+}
+
+#endif //INTERSECTIONS_COMPACT_INTERSECTIONS_H
@@ -0,0 +1,97 @@
+/// \file
+/// \brief definition of intersections::CostModel, which chooses the solution for solve<Solution::automatic>
+
+#ifndef INTERSECTIONS_COST_MODEL_H
+#define INTERSECTIONS_COST_MODEL_H
+
+#include <intersections.h>
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace intersections {
+    // the solutions which solve<Solution::automatic> chooses between, in order of Solution
+    constexpr std::size_t num_engines = std::size_t(Solution::automatic);
+
+    // the features of a set of rectangles from which the time to solve it is predicted
+    struct Workload {
+        std::size_t num_rectangles = 0;
+
+        // the mean number of other rectangles which each rectangle overlaps,
+        // estimated from a sample of pairs
+        double mean_degree = 0;
+
+        // the memory needed by the grid of solve<Solution::grid>
+        std::size_t grid_bytes = 0;
+
+        // the memory needed by the bitsets of solve<Solution::cliques>
+        std::size_t cliques_bytes = 0;
+    };
+
+    // returns the features of rectangles;
+    // takes O(n log n) time, which is small next to the time to solve them
+    Workload measure(Rectangles const& rectangles);
+
+    // returns the name of solution as used in cost model files
+    char const* to_string(Solution solution) noexcept;
+
+    // sets solution to the solution named name; returns false if there is none
+    bool from_string(char const* name, Solution& solution) noexcept;
+
+    // predicts the time each solution takes to solve a workload
+    // as a log-linear function of its features whose coefficients are fitted to timed runs
+    class CostModel {
+    public:
+        // the natural logarithm of the time predicted is the dot product of the coefficients and the features:
+        // 1, ln(1+n), ln(1+n)^2, d, ln(1+d) and ln(1+g) for n rectangles of mean degree d and grid bytes g
+        using Coefficients = std::array<double, 6>;
+
+        // the time taken by a solution to solve a workload
+        struct Sample {
+            Solution solution;
+            Workload workload;
+            double seconds;
+        };
+
+        // a model fitted on the machine on which the library was developed
+        CostModel() noexcept;
+
+        // returns the predicted time in seconds for solution to solve workload
+        double predict(Solution solution, Workload const& workload) const noexcept;
+
+        // returns the solution which is predicted to solve workload fastest;
+        // solutions which cannot solve workload within their memory limits are not considered
+        Solution choose(Workload const& workload) const noexcept;
+
+        // replaces the coefficients of each solution which has samples with a least-squares fit to them;
+        // the solutions without samples keep their coefficients
+        void fit(std::vector<Sample> const& samples);
+
+        // writes the coefficients to a text file, one solution per line; returns false on failure
+        bool save(char const* filename) const;
+
+        // reads the coefficients written by save; returns false and keeps the current coefficients on failure;
+        // solutions which are not in the file keep their coefficients
+        bool load(char const* filename);
+
+        Coefficients const& coefficients(Solution solution) const noexcept
+        {
+            assert(std::size_t(solution)<num_engines);
+            return engines[std::size_t(solution)];
+        }
+
+    private:
+        std::array<Coefficients, num_engines> engines;
+    };
+
+    // returns the model used by solve<Solution::automatic>
+    CostModel const& cost_model() noexcept;
+
+    // replaces the model used by solve<Solution::automatic>;
+    // warning: not safe while any thread is in solve<Solution::automatic>, so call it at startup
+    void set_cost_model(CostModel const& model) noexcept;
+}
+
+#endif //INTERSECTIONS_COST_MODEL_H
@@ -0,0 +1,21 @@
+/// \file
+/// \brief declaration of intersections::union_area and intersections::coverage_area
+
+#ifndef INTERSECTIONS_COVERAGE_H
+#define INTERSECTIONS_COVERAGE_H
+
+#include <intersections.h>
+
+#include <cstdint>
+
+namespace intersections {
+    // returns the area covered by at least one of the rectangles;
+    // runs in O(n log n) time
+    std::int64_t union_area(Rectangles const& rectangles);
+
+    // returns the area covered by at least min_depth of the rectangles;
+    // runs in O(n log n min_depth) time
+    std::int64_t coverage_area(Rectangles const& rectangles, int min_depth);
+}
+
+#endif //INTERSECTIONS_COVERAGE_H
@@ -0,0 +1,41 @@
+/// \file
+/// \brief declaration of intersections::max_depth and related types
+
+#ifndef INTERSECTIONS_DEPTH_H
+#define INTERSECTIONS_DEPTH_H
+
+#include <intersections.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace intersections {
+    // the deepest stack of overlapping rectangles
+    struct MaxDepth {
+        // the greatest number of rectangles which overlap at any point
+        int depth = 0;
+
+        // the area of overlap of constituents, all of which is at depth
+        Rectangle region;
+
+        // the rectangles which overlap at region, in input order;
+        // warning: contains non-owning pointers
+        RectangleSequence constituents;
+    };
+
+    // area_by_depth[d] is the area within the bounds of the rectangles
+    // which is covered by exactly d rectangles
+    using AreaByDepth = std::vector<std::int64_t>;
+
+    // given a set of rectangles, return the greatest depth of overlap and where it occurs;
+    // runs in O(n log n) time
+    MaxDepth max_depth(Rectangles const& rectangles);
+
+    // as above, and also fill area_by_depth;
+    // unlike the overload above, this takes O(n^2) time in the worst case
+    // as each of the 2n edges of the sweep visits every run of uniform depth across the sweep line,
+    // of which there can be O(n)
+    MaxDepth max_depth(Rectangles const& rectangles, AreaByDepth& area_by_depth);
+}
+
+#endif //INTERSECTIONS_DEPTH_H
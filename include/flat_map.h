@@ -0,0 +1,334 @@
+/// \file
+/// \brief definition of intersections::FlatMap
+
+#ifndef INTERSECTIONS_FLAT_MAP_H
+#define INTERSECTIONS_FLAT_MAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace intersections {
+    // associative container with a subset of the interface of std::unordered_map;
+    // implemented as an open-addressing hash table using Robin Hood hashing
+    // so that entries are stored contiguously and lookups probe few, adjacent slots;
+    // Key and Value must be default-constructible;
+    // warning: insertion and erasure invalidate iterators
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class FlatMap {
+        struct Slot;
+
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using size_type = std::size_t;
+
+        template<typename SlotPointer, typename Reference>
+        class basic_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = FlatMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::remove_reference_t<Reference>*;
+            using reference = Reference;
+
+            basic_iterator() = default;
+
+            basic_iterator(SlotPointer slot, SlotPointer last) noexcept
+                    :slot(slot), last(last)
+            {
+                skip_empty_slots();
+            }
+
+            // conversion from iterator to const_iterator
+            template<typename ThatSlotPointer, typename ThatReference>
+            basic_iterator(basic_iterator<ThatSlotPointer, ThatReference> const& that) noexcept
+                    :slot(that.slot), last(that.last)
+            {
+            }
+
+            reference operator*() const noexcept
+            {
+                return slot->value;
+            }
+
+            pointer operator->() const noexcept
+            {
+                return &slot->value;
+            }
+
+            basic_iterator& operator++() noexcept
+            {
+                ++slot;
+                skip_empty_slots();
+                return *this;
+            }
+
+            basic_iterator operator++(int) noexcept
+            {
+                auto const previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(basic_iterator const& lhs, basic_iterator const& rhs) noexcept
+            {
+                return lhs.slot==rhs.slot;
+            }
+
+            friend bool operator!=(basic_iterator const& lhs, basic_iterator const& rhs) noexcept
+            {
+                return !(lhs==rhs);
+            }
+
+        private:
+            template<typename, typename>
+            friend class basic_iterator;
+
+            friend class FlatMap;
+
+            void skip_empty_slots() noexcept
+            {
+                while (slot!=last && slot->distance==0) {
+                    ++slot;
+                }
+            }
+
+            SlotPointer slot = nullptr;
+            SlotPointer last = nullptr;
+        };
+
+        using iterator = basic_iterator<Slot*, value_type&>;
+        using const_iterator = basic_iterator<Slot const*, value_type const&>;
+
+        FlatMap() = default;
+
+        FlatMap(std::initializer_list<value_type> values)
+        {
+            reserve(values.size());
+            for (auto const& value : values) {
+                emplace(value.first, value.second);
+            }
+        }
+
+        auto empty() const noexcept
+        {
+            return size()==0;
+        }
+
+        auto size() const noexcept
+        {
+            return num_values;
+        }
+
+        auto begin() noexcept
+        {
+            return iterator(slots.data(), slots.data()+slots.size());
+        }
+
+        auto begin() const noexcept
+        {
+            return const_iterator(slots.data(), slots.data()+slots.size());
+        }
+
+        auto end() noexcept
+        {
+            auto const last = slots.data()+slots.size();
+            return iterator(last, last);
+        }
+
+        auto end() const noexcept
+        {
+            auto const last = slots.data()+slots.size();
+            return const_iterator(last, last);
+        }
+
+        void clear() noexcept
+        {
+            slots.clear();
+            num_values = 0;
+        }
+
+        // ensure that num_values values can be held without rehashing
+        void reserve(size_type const capacity)
+        {
+            auto num_slots = size_type{min_num_slots};
+            while (!fits(capacity, num_slots)) {
+                num_slots *= 2;
+            }
+
+            if (num_slots>slots.size()) {
+                rehash(num_slots);
+            }
+        }
+
+        iterator find(Key const& key) noexcept
+        {
+            auto const index = find_index(key);
+            return (index==not_found) ? end() : iterator(slots.data()+index, slots.data()+slots.size());
+        }
+
+        const_iterator find(Key const& key) const noexcept
+        {
+            auto const index = find_index(key);
+            return (index==not_found) ? end() : const_iterator(slots.data()+index, slots.data()+slots.size());
+        }
+
+        // insert value at key unless key is already present;
+        // returns the entry at key and true iff it was inserted
+        template<typename KeyArgument, typename ValueArgument>
+        std::pair<iterator, bool> emplace(KeyArgument&& key, ValueArgument&& value)
+        {
+            auto candidate = value_type(std::forward<KeyArgument>(key), std::forward<ValueArgument>(value));
+
+            auto const found = find_index(candidate.first);
+            if (found!=not_found) {
+                return std::make_pair(iterator(slots.data()+found, slots.data()+slots.size()), false);
+            }
+
+            if (!fits(num_values+1, slots.size())) {
+                rehash(std::max(size_type{min_num_slots}, slots.size()*2));
+            }
+
+            auto const index = insert_new(std::move(candidate));
+            return std::make_pair(iterator(slots.data()+index, slots.data()+slots.size()), true);
+        }
+
+        // remove the entry at key; returns the number of entries removed
+        size_type erase(Key const& key) noexcept
+        {
+            auto index = find_index(key);
+            if (index==not_found) {
+                return 0;
+            }
+
+            // shift subsequent entries back to fill the gap
+            auto const mask = slots.size()-1;
+            for (auto next = (index+1) & mask; slots[next].distance>1; index = next, next = (next+1) & mask) {
+                slots[index].value = std::move(slots[next].value);
+                slots[index].distance = slots[next].distance-1;
+            }
+            slots[index].value = value_type{};
+            slots[index].distance = 0;
+
+            --num_values;
+            return 1;
+        }
+
+        friend bool operator==(FlatMap const& lhs, FlatMap const& rhs)
+        {
+            if (lhs.size()!=rhs.size()) {
+                return false;
+            }
+
+            return std::all_of(std::begin(lhs), std::end(lhs), [&rhs](value_type const& value) {
+                auto const found = rhs.find(value.first);
+                return found!=std::end(rhs) && found->second==value.second;
+            });
+        }
+
+        friend bool operator!=(FlatMap const& lhs, FlatMap const& rhs)
+        {
+            return !(lhs==rhs);
+        }
+
+    private:
+        struct Slot {
+            // one greater than the distance from the slot to which value hashes, or zero if empty
+            std::uint32_t distance = 0;
+
+            value_type value;
+        };
+
+        static constexpr auto min_num_slots = 8;
+        static constexpr size_type not_found = ~size_type{0};
+
+        // true iff num_values fit in num_slots without exceeding a load factor of 7/8
+        static constexpr bool fits(size_type const num_values, size_type const num_slots) noexcept
+        {
+            return num_values*8<=num_slots*7;
+        }
+
+        size_type home_index(Key const& key) const noexcept
+        {
+            return size_type(Hash{}(key)) & (slots.size()-1);
+        }
+
+        size_type find_index(Key const& key) const noexcept
+        {
+            if (slots.empty()) {
+                return not_found;
+            }
+
+            auto const mask = slots.size()-1;
+            auto index = home_index(key);
+            for (auto distance = std::uint32_t{1};; ++distance, index = (index+1) & mask) {
+                auto const& slot = slots[index];
+
+                // Robin Hood invariant: key would have displaced any entry which is closer to home
+                if (slot.distance<distance) {
+                    return not_found;
+                }
+
+                if (KeyEqual{}(slot.value.first, key)) {
+                    return index;
+                }
+            }
+        }
+
+        // add value, known to be absent, to a table with room for it; returns its index
+        size_type insert_new(value_type&& value)
+        {
+            auto const mask = slots.size()-1;
+            auto index = home_index(value.first);
+            auto inserted_index = not_found;
+            for (auto distance = std::uint32_t{1};; ++distance, index = (index+1) & mask) {
+                auto& slot = slots[index];
+                if (slot.distance==0) {
+                    slot.distance = distance;
+                    slot.value = std::move(value);
+                    ++num_values;
+                    return (inserted_index==not_found) ? index : inserted_index;
+                }
+
+                // take from the rich and give to the poor
+                if (slot.distance<distance) {
+                    if (inserted_index==not_found) {
+                        inserted_index = index;
+                    }
+
+                    using std::swap;
+                    swap(slot.value, value);
+                    swap(slot.distance, distance);
+                }
+            }
+        }
+
+        void rehash(size_type const num_slots)
+        {
+            assert(num_slots>=min_num_slots && (num_slots & (num_slots-1))==0);
+
+            auto old_slots = std::vector<Slot>(num_slots);
+            old_slots.swap(slots);
+            num_values = 0;
+
+            for (auto& old_slot : old_slots) {
+                if (old_slot.distance!=0) {
+                    insert_new(std::move(old_slot.value));
+                }
+            }
+        }
+
+        std::vector<Slot> slots;
+        size_type num_values = 0;
+    };
+}
+
+#endif //INTERSECTIONS_FLAT_MAP_H
@@ -0,0 +1,34 @@
+/// \file
+/// \brief declaration of the memory budget of intersections::solve<Solution::grid> and the bound on its time
+
+#ifndef INTERSECTIONS_GRID_H
+#define INTERSECTIONS_GRID_H
+
+#include <intersections.h>
+
+#include <cstddef>
+
+namespace intersections {
+    // the most memory which solve<Solution::grid> allocates for its grid;
+    // it throws std::length_error rather than exceed this
+    constexpr std::size_t max_grid_bytes = std::size_t{1} << 28;
+
+    // returns the memory which solve<Solution::grid> needs for the grid of rectangles:
+    // a bitmask of the rectangles for each cell between the distinct coordinates of their edges
+    std::size_t grid_bytes(Rectangles const& rectangles);
+
+    // solve<Solution::grid> bounds its memory but not its time:
+    // from each cell it examines boxes of cells, growing right and down while their corners share
+    // at least min_constituents rectangles, and compares masks of n/64 words for each box;
+    // a box is only grown from the top-left corner of a rectangle or of the overlap of two, and only within it,
+    // so with x and y distinct coordinates it examines O(x y) boxes plus the cells of those overlaps;
+    // that is O(x² y²) when, e.g., wide rectangles starting on each row cross tall rectangles starting on each column
+
+    // true iff solve<Solution::grid> can solve rectangles within max_grid_bytes
+    inline bool grid_fits(Rectangles const& rectangles)
+    {
+        return grid_bytes(rectangles)<=max_grid_bytes;
+    }
+}
+
+#endif //INTERSECTIONS_GRID_H
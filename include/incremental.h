@@ -0,0 +1,105 @@
+/// \file
+/// \brief definition of intersections::IncrementalSolver
+
+#ifndef INTERSECTIONS_INCREMENTAL_H
+#define INTERSECTIONS_INCREMENTAL_H
+
+#include <intersections.h>
+#include <rectangle_batch.h>
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace intersections {
+    // maintains the intersections of a set of rectangles as rectangles are inserted, erased and moved;
+    // a change to one rectangle can only change the overlaps within it
+    // so only the rectangles which overlap it are solved again
+    class IncrementalSolver {
+    public:
+        // identifies a rectangle for as long as it is in the solver;
+        // the identifiers of erased rectangles are reused
+        using Id = std::uint32_t;
+
+        // the rectangles which produce an area of overlap, in ascending order of Id
+        using Constituents = std::vector<Id>;
+
+        using Result = std::pair<Rectangle, Constituents>;
+
+        using Results = FlatMap<Rectangle, Constituents>;
+
+        // the changes to the results caused by a change to the rectangles;
+        // an overlap whose constituents change is both removed and added
+        struct Delta {
+            std::vector<Result> added;
+            std::vector<Result> removed;
+        };
+
+        IncrementalSolver() = default;
+
+        // the rectangles are given the Ids of their indices
+        explicit IncrementalSolver(Rectangles const& rectangles);
+
+        // returns the number of rectangles in the solver
+        auto size() const noexcept
+        {
+            return num_rectangles;
+        }
+
+        // true iff id identifies a rectangle in the solver
+        bool is_live(Id const id) const noexcept
+        {
+            constexpr auto bits_per_word = RectangleBatch::rectangles_per_word;
+            return id<rectangles.size() && ((live[id/bits_per_word] >> (id%bits_per_word)) & 1);
+        }
+
+        Rectangle const& rectangle(Id const id) const noexcept
+        {
+            assert(is_live(id));
+            return rectangles[id];
+        }
+
+        // returns every area of overlap and the rectangles which produce it
+        Results const& results() const noexcept
+        {
+            return overlaps;
+        }
+
+        // add a rectangle, appending the changes to the results to delta;
+        // returns the Id of the new rectangle
+        Id insert(Rectangle const& rectangle, Delta& delta);
+
+        // remove the rectangle identified by id, appending the changes to the results to delta
+        void erase(Id id, Delta& delta);
+
+        // replace the rectangle identified by id, appending the changes to the results to delta
+        void move(Id id, Rectangle const& rectangle, Delta& delta);
+
+    private:
+        // add to window_results the results which lie within window,
+        // solving only the rectangles which overlap it
+        void solve_window(Rectangle const& window, Results& window_results);
+
+        // replace the results in previous with those in updated and append the changes to delta
+        void update(Results const& previous, Results const& updated, Delta& delta);
+
+        // indexed by Id; the rectangles of erased Ids are stale
+        Rectangles rectangles;
+        RectangleBatch batch;
+
+        // a mask for each word of batch of the Ids which are in the solver
+        std::vector<std::uint64_t> live;
+
+        // Ids which are not in the solver, most recently erased last
+        std::vector<Id> free_ids;
+        std::size_t num_rectangles = 0;
+
+        Results overlaps;
+
+        // working memory of solve_window, reused between changes
+        Arena arena;
+    };
+}
+
+#endif //INTERSECTIONS_INCREMENTAL_H
@@ -8,28 +8,130 @@
 #ifndef INTERSECTIONS_H
 #define INTERSECTIONS_H
 
+#include <arena.h>
+#include <flat_map.h>
 #include <rectangle.h>
+#include <solve_stats.h>
 
-#include <unordered_map>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <vector>
 
 namespace intersections {
     enum class Solution {
         simple,
-        fast
+        fast,
+
+        // fast, with the outer sweep divided between threads into runs which are reported in order;
+        // the results of up to two runs per thread are held until they are reported
+        fast_parallel,
+
+        // fast, applied in parallel to tiles of the plane which are reported in order;
+        // the results of up to two tiles per thread are held until they are reported;
+        // suits large, sparse sets of rectangles
+        tiled,
+
+        // enumeration of the cliques of the graph of overlapping rectangles;
+        // suits small, dense sets of rectangles
+        cliques,
+
+        // a bitmask of the covering rectangles for each cell of the grid of edge coordinates;
+        // suits rectangles with few distinct coordinates; see grid.h for its memory budget
+        grid,
+
+        // whichever of the above is predicted to be fastest for the rectangles; see cost_model.h
+        automatic
     };
 
     // warning: contain non-owning pointers
-    using RectangleSequence = std::vector<Rectangle const*>;
+    using RectangleSequence = ArenaVector<Rectangle const*>;
 
-    using Intersections = std::unordered_map<Rectangle, RectangleSequence>;
+    using Intersections = FlatMap<Rectangle, RectangleSequence>;
 
     using Rectangles = std::vector<Rectangle>;
 
-    // given a set of rectangles, return the map from overlap area to rectangles which overlap;
-    // warning: returns non-owning pointers to input rectangles
+    // receives an area of overlap and the rectangles which overlap there, in input order;
+    // warning: constituents are only valid for the duration of the call
+    using Visitor = std::function<void(Rectangle const& overlap, RectangleSequence const& constituents)>;
+
+    // limits on the overlaps reported by solve;
+    // overlaps outside the limits are pruned during the search rather than filtered afterwards
+    struct SolveOptions {
+        // overlaps of fewer rectangles are not reported; must be at least 2
+        std::size_t min_constituents = 2;
+
+        // overlaps of smaller area are not reported
+        std::int64_t min_area = 0;
+
+        // the search stops once this many overlaps have been reported
+        std::size_t max_results = std::numeric_limits<std::size_t>::max();
+
+        // if not null, the counters and timings of the call are added to it; see solve_stats.h
+        SolveStats* stats = nullptr;
+    };
+
+    // true iff the overlap of num_constituents rectangles is within the limits of options
+    constexpr bool accepts(
+            SolveOptions const& options, Rectangle const& overlap, std::size_t num_constituents) noexcept
+    {
+        return num_constituents>=options.min_constituents
+               && std::int64_t(overlap.w())*overlap.h()>=options.min_area;
+    }
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap within the limits of options;
+    // results are not retained, beyond what the parallel solutions above hold until it is reported,
+    // so memory use does not grow with the number of results;
+    // working memory is allocated from arena and reclaimed on return
+    // so an arena which is reused between calls soon stops allocating from the heap
     template<Solution>
-    Intersections solve(Rectangles const& rectangles);
+    void solve(Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena);
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap;
+    // working memory is allocated from arena and reclaimed on return
+    template<Solution solution>
+    void solve(Rectangles const& rectangles, Visitor const& visitor, Arena& arena)
+    {
+        solve<solution>(rectangles, visitor, SolveOptions{}, arena);
+    }
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap within the limits of options
+    template<Solution solution>
+    void solve(Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options)
+    {
+        Arena arena;
+        solve<solution>(rectangles, visitor, options, arena);
+    }
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap;
+    // results are not retained, beyond what the parallel solutions hold until it is reported,
+    // so memory use does not grow with the number of results
+    template<Solution solution>
+    void solve(Rectangles const& rectangles, Visitor const& visitor)
+    {
+        Arena arena;
+        solve<solution>(rectangles, visitor, arena);
+    }
+
+    // given a set of rectangles, return the map from overlap area to rectangles which overlap
+    // for the overlaps within the limits of options;
+    // warning: returns non-owning pointers to input rectangles
+    template<Solution solution>
+    Intersections solve(Rectangles const& rectangles, SolveOptions const& options = SolveOptions{})
+    {
+        Intersections intersections;
+        auto const visitor = [&intersections, &options](
+                Rectangle const& overlap, RectangleSequence const& constituents) {
+            record(options.stats, &SolveStats::Counters::hash_probes);
+            if (!intersections.emplace(overlap, constituents).second) {
+                // each overlap should only be visited once
+                assert(false);
+            }
+        };
+        solve<solution>(rectangles, visitor, options);
+        return intersections;
+    }
 }
 
 #endif //INTERSECTIONS_H
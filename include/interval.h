@@ -59,6 +59,12 @@ namespace intersections {
         return position>=i.start && position<i.end;
     }
 
+    // returns true iff inner lies entirely within outer
+    constexpr bool contains(Interval const& outer, Interval const& inner) noexcept
+    {
+        return inner.start>=outer.start && inner.end<=outer.end;
+    }
+
     // returns intersection of a and b
     constexpr auto operator&(Interval const& a, Interval const& b) noexcept
     {
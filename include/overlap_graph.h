@@ -0,0 +1,81 @@
+/// \file
+/// \brief definition of intersections::OverlapGraph and declaration of intersections::overlapping_pairs
+
+#ifndef INTERSECTIONS_OVERLAP_GRAPH_H
+#define INTERSECTIONS_OVERLAP_GRAPH_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace intersections {
+    // undirected graph with one vertex per input rectangle
+    // and an edge between each pair of rectangles which overlap;
+    // the neighbors of each vertex are stored contiguously in ascending order
+    // as indices into the input rectangles (compressed sparse row layout)
+    class OverlapGraph {
+    public:
+        using Index = std::uint32_t;
+
+        // the indices of the rectangles which overlap a single rectangle
+        struct Neighbors {
+            Index const* first;
+            Index const* last;
+
+            constexpr auto begin() const noexcept { return first; }
+
+            constexpr auto end() const noexcept { return last; }
+
+            constexpr auto size() const noexcept { return std::size_t(last-first); }
+        };
+
+        OverlapGraph() = default;
+
+        // offsets[n] and offsets[n+1] delimit the neighbors of vertex n in indices
+        OverlapGraph(std::vector<std::size_t> offsets, std::vector<Index> indices) noexcept
+                :offsets(std::move(offsets)), indices(std::move(indices))
+        {
+            assert(!this->offsets.empty() && this->offsets.back()==this->indices.size());
+        }
+
+        auto num_vertices() const noexcept
+        {
+            return offsets.size()-1;
+        }
+
+        auto num_edges() const noexcept
+        {
+            return indices.size()/2;
+        }
+
+        // returns the indices of the rectangles which overlap the nth rectangle
+        Neighbors neighbors(std::size_t n) const noexcept
+        {
+            assert(n<num_vertices());
+            auto const data = indices.data();
+            return Neighbors{data+offsets[n], data+offsets[n+1]};
+        }
+
+        friend bool operator==(OverlapGraph const& lhs, OverlapGraph const& rhs) noexcept
+        {
+            return lhs.offsets==rhs.offsets && lhs.indices==rhs.indices;
+        }
+
+        friend bool operator!=(OverlapGraph const& lhs, OverlapGraph const& rhs) noexcept
+        {
+            return !(lhs==rhs);
+        }
+
+    private:
+        std::vector<std::size_t> offsets = std::vector<std::size_t>(1, 0);
+        std::vector<Index> indices;
+    };
+
+    // given a set of rectangles, return the graph of which pairs of rectangles overlap;
+    // runs in O(n log n + k) time for n rectangles and k overlapping pairs
+    OverlapGraph overlapping_pairs(Rectangles const& rectangles);
+}
+
+#endif //INTERSECTIONS_OVERLAP_GRAPH_H
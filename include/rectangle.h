@@ -12,6 +12,8 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <limits>
 
 namespace intersections {
@@ -71,6 +73,11 @@ namespace intersections {
                 && lhs.interval(Axis::vertical)==rhs.interval(Axis::vertical);
     }
 
+    constexpr auto operator!=(Rectangle const lhs, Rectangle const rhs) noexcept
+    {
+        return !(lhs==rhs);
+    }
+
     constexpr auto operator<(Rectangle const lhs, Rectangle const rhs) noexcept
     {
         return (lhs.interval(Axis::horizontal)<rhs.interval(Axis::horizontal))
@@ -95,6 +102,13 @@ namespace intersections {
         return contains(r.interval(Axis::horizontal), x) && contains(r.interval(Axis::vertical), y);
     }
 
+    // returns true iff inner lies entirely within outer
+    constexpr bool contains(Rectangle const outer, Rectangle const inner) noexcept
+    {
+        return contains(outer.interval(Axis::horizontal), inner.interval(Axis::horizontal))
+                && contains(outer.interval(Axis::vertical), inner.interval(Axis::vertical));
+    }
+
     constexpr Rectangle maximum_rectangle = Rectangle::from_intervals(
             Interval{std::numeric_limits<int>::min(), std::numeric_limits<int>::max()},
             Interval{std::numeric_limits<int>::min(), std::numeric_limits<int>::max()});
@@ -103,12 +117,28 @@ namespace intersections {
 namespace std {
     template<>
     struct hash<intersections::Rectangle> {
+        // combines the two intervals, each packed into 64 bits, into a well-mixed 64-bit hash;
+        // this is the 128-to-64-bit mixing function from CityHash
         constexpr std::size_t operator()(intersections::Rectangle const& rectangle) const noexcept
         {
-            return static_cast<std::size_t>(rectangle.interval(intersections::Axis::horizontal).start)
-                    ^ (static_cast<std::size_t>(rectangle.interval(intersections::Axis::horizontal).end) << 10)
-                    ^ (static_cast<std::size_t>(rectangle.interval(intersections::Axis::vertical).start) << 20)
-                    ^ (static_cast<std::size_t>(rectangle.interval(intersections::Axis::vertical).end) << 30);
+            using intersections::Axis;
+            constexpr auto multiplier = std::uint64_t{0x9ddfea08eb382d69};
+
+            auto const low = pack(rectangle.interval(Axis::horizontal));
+            auto const high = pack(rectangle.interval(Axis::vertical));
+
+            auto a = (low ^ high)*multiplier;
+            a ^= (a >> 47);
+            auto b = (high ^ a)*multiplier;
+            b ^= (b >> 47);
+            b *= multiplier;
+            return static_cast<std::size_t>(b);
+        }
+
+    private:
+        static constexpr std::uint64_t pack(intersections::Interval const& interval) noexcept
+        {
+            return std::uint64_t(std::uint32_t(interval.start)) | (std::uint64_t(std::uint32_t(interval.end)) << 32);
         }
     };
 }
@@ -0,0 +1,151 @@
+/// \file
+/// \brief definition of intersections::RectangleBatch and the kernels which operate on it
+
+#ifndef INTERSECTIONS_RECTANGLE_BATCH_H
+#define INTERSECTIONS_RECTANGLE_BATCH_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace intersections {
+    // sequence of rectangles stored as a structure of arrays
+    // so that many rectangles can be tested at once using SIMD instructions;
+    // rectangles are grouped into words of 64 and each array is padded to a whole number of words
+    // with rectangles which overlap nothing;
+    // memory is allocated from an optional Arena
+    class RectangleBatch {
+    public:
+        static constexpr std::size_t rectangles_per_word = 64;
+
+        // the alignment of the arrays of coordinates
+        static constexpr std::size_t alignment = 64;
+
+        explicit RectangleBatch(Arena* arena = nullptr) noexcept
+                :x0s(arena), x1s(arena), y0s(arena), y1s(arena)
+        {
+        }
+
+        explicit RectangleBatch(Rectangles const& rectangles, Arena* arena = nullptr)
+                :RectangleBatch(arena)
+        {
+            reserve(rectangles.size());
+            for (auto const& rectangle : rectangles) {
+                push_back(rectangle);
+            }
+        }
+
+        auto empty() const noexcept
+        {
+            return num_rectangles==0;
+        }
+
+        auto size() const noexcept
+        {
+            return num_rectangles;
+        }
+
+        // returns the number of words of rectangles
+        auto num_words() const noexcept
+        {
+            return x0s.size()/rectangles_per_word;
+        }
+
+        Rectangle operator[](std::size_t n) const noexcept
+        {
+            assert(n<size());
+            return Rectangle::from_intervals(Interval{x0s[n], x1s[n]}, Interval{y0s[n], y1s[n]});
+        }
+
+        void reserve(std::size_t const capacity)
+        {
+            auto const padded_capacity = (capacity+rectangles_per_word-1)/rectangles_per_word*rectangles_per_word;
+            for (auto coordinates : {&x0s, &x1s, &y0s, &y1s}) {
+                coordinates->reserve(padded_capacity);
+            }
+        }
+
+        void push_back(Rectangle const& rectangle)
+        {
+            if (num_rectangles==x0s.size()) {
+                // add a word of padding; the intervals of padding overlap no other intervals
+                for (auto starts : {&x0s, &y0s}) {
+                    starts->resize(starts->size()+rectangles_per_word, std::numeric_limits<int>::max());
+                }
+                for (auto ends : {&x1s, &y1s}) {
+                    ends->resize(ends->size()+rectangles_per_word, std::numeric_limits<int>::lowest());
+                }
+            }
+
+            ++num_rectangles;
+            assign(num_rectangles-1, rectangle);
+        }
+
+        // replace the nth rectangle
+        void assign(std::size_t const n, Rectangle const& rectangle) noexcept
+        {
+            assert(n<size());
+            x0s[n] = rectangle.interval(Axis::horizontal).start;
+            x1s[n] = rectangle.interval(Axis::horizontal).end;
+            y0s[n] = rectangle.interval(Axis::vertical).start;
+            y1s[n] = rectangle.interval(Axis::vertical).end;
+        }
+
+        void clear() noexcept
+        {
+            for (auto coordinates : {&x0s, &x1s, &y0s, &y1s}) {
+                coordinates->clear();
+            }
+            num_rectangles = 0;
+        }
+
+        // arrays of coordinates, aligned to alignment and num_words()*rectangles_per_word in length
+        int const* x0() const noexcept { return x0s.data(); }
+
+        int const* x1() const noexcept { return x1s.data(); }
+
+        int const* y0() const noexcept { return y0s.data(); }
+
+        int const* y1() const noexcept { return y1s.data(); }
+
+    private:
+        using Coordinates = std::vector<int, ArenaAllocator<int, alignment>>;
+
+        Coordinates x0s;
+        Coordinates x1s;
+        Coordinates y0s;
+        Coordinates y1s;
+        std::size_t num_rectangles = 0;
+    };
+
+    // instruction sets with which kernels are implemented
+    enum class Isa {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    // returns true iff kernels implemented with isa can run on this system
+    bool is_supported(Isa isa) noexcept;
+
+    // returns the fastest instruction set which is supported by this system
+    Isa best_isa() noexcept;
+
+    // returns a mask of the rectangles in the given word of batch
+    // which overlap rectangle with positive area
+    std::uint64_t overlap_word(RectangleBatch const& batch, std::size_t word, Rectangle const& rectangle) noexcept;
+
+    // as above, using the given supported instruction set
+    std::uint64_t overlap_word(
+            RectangleBatch const& batch, std::size_t word, Rectangle const& rectangle, Isa isa) noexcept;
+
+    // returns one row of batch.num_words() words per rectangle in batch;
+    // bit m of row n is set iff rectangles n and m are different and overlap with positive area
+    std::vector<std::uint64_t> overlap_matrix(RectangleBatch const& batch, Isa isa = best_isa());
+}
+
+#endif //INTERSECTIONS_RECTANGLE_BATCH_H
@@ -0,0 +1,95 @@
+/// \file
+/// \brief definition of intersections::RectangleFile, a binary file format for rectangles
+
+#ifndef INTERSECTIONS_RECTANGLE_FILE_H
+#define INTERSECTIONS_RECTANGLE_FILE_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace intersections {
+    // read-only view of a binary file of rectangles which is mapped into memory rather than read;
+    // the file, in little-endian byte order, is a header of
+    //   the magic number, "RECT", 4 bytes
+    //   the version, 1, 4 bytes
+    //   the number of rectangles, n, 8 bytes
+    //   the width of a coordinate, 2 or 4 bytes, 4 bytes
+    //   reserved, 0, 4 bytes
+    // followed by n signed x coordinates, n y coordinates, n widths and n heights, each of the given width
+    class RectangleFile {
+    public:
+        static constexpr std::size_t header_size = 24;
+
+        RectangleFile() = default;
+
+        RectangleFile(RectangleFile const&) = delete;
+
+        RectangleFile& operator=(RectangleFile const&) = delete;
+
+        ~RectangleFile();
+
+        // maps the named file; returns false and leaves the view empty if it is not a valid rectangle file
+        // or if any of its rectangles has a width or height which is not positive
+        // or extends beyond the largest int
+        bool open(char const* filename);
+
+        void close() noexcept;
+
+        auto empty() const noexcept
+        {
+            return size()==0;
+        }
+
+        // the number of rectangles in the file
+        std::size_t size() const noexcept
+        {
+            return num_rectangles;
+        }
+
+        // the bytes in each coordinate, 2 or 4
+        int coordinate_width() const noexcept
+        {
+            return width;
+        }
+
+        // returns the nth rectangle, read straight from the mapped file
+        Rectangle operator[](std::size_t const n) const noexcept
+        {
+            assert(n<size());
+            return Rectangle{coordinate(0, n), coordinate(1, n), coordinate(2, n), coordinate(3, n)};
+        }
+
+        // returns a copy of the rectangles, in the form taken by solve
+        Rectangles rectangles() const;
+
+    private:
+        // returns the nth element of an array: 0 for x, 1 for y, 2 for width and 3 for height
+        int coordinate(std::size_t const array, std::size_t const n) const noexcept
+        {
+            auto const index = array*num_rectangles+n;
+            return (width==2)
+                   ? int(reinterpret_cast<std::int16_t const*>(arrays)[index])
+                   : int(reinterpret_cast<std::int32_t const*>(arrays)[index]);
+        }
+
+        // the mapped file and, on platforms without memory mapping, the memory it was read into
+        void* mapping = nullptr;
+        std::size_t mapping_size = 0;
+
+        void const* arrays = nullptr;
+        std::size_t num_rectangles = 0;
+        int width = 0;
+    };
+
+    // returns true iff the named file begins with the magic number of a RectangleFile
+    bool is_rectangle_file(char const* filename);
+
+    // writes rectangles to a file in the format read by RectangleFile
+    // with the narrowest coordinates in which they fit; returns false on failure
+    bool save_rectangle_file(char const* filename, Rectangles const& rectangles);
+}
+
+#endif //INTERSECTIONS_RECTANGLE_FILE_H
@@ -0,0 +1,135 @@
+/// \file
+/// \brief definition of intersections::RTree and related types
+
+#ifndef INTERSECTIONS_RTREE_H
+#define INTERSECTIONS_RTREE_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace intersections {
+    struct Point {
+        int x;
+        int y;
+    };
+
+    // the results of a batch of queries;
+    // the results of each query are stored contiguously in ascending order
+    // as indices into the indexed rectangles (compressed sparse row layout)
+    class QueryResults {
+    public:
+        using Index = std::uint32_t;
+
+        // the indices of the rectangles found by a single query
+        struct Matches {
+            Index const* first;
+            Index const* last;
+
+            constexpr auto begin() const noexcept { return first; }
+
+            constexpr auto end() const noexcept { return last; }
+
+            constexpr auto size() const noexcept { return std::size_t(last-first); }
+        };
+
+        QueryResults() = default;
+
+        // offsets[n] and offsets[n+1] delimit the matches of query n in indices
+        QueryResults(std::vector<std::size_t> offsets, std::vector<Index> indices) noexcept
+                :offsets(std::move(offsets)), indices(std::move(indices))
+        {
+            assert(!this->offsets.empty() && this->offsets.back()==this->indices.size());
+        }
+
+        auto size() const noexcept
+        {
+            return offsets.size()-1;
+        }
+
+        // returns the indices of the rectangles found by the nth query
+        Matches matches(std::size_t n) const noexcept
+        {
+            assert(n<size());
+            auto const data = indices.data();
+            return Matches{data+offsets[n], data+offsets[n+1]};
+        }
+
+    private:
+        std::vector<std::size_t> offsets = std::vector<std::size_t>(1, 0);
+        std::vector<Index> indices;
+    };
+
+    // static spatial index over a set of rectangles;
+    // bulk-loaded using Sort-Tile-Recursive packing
+    // into nodes which store the bounds of their children as aligned arrays
+    class RTree {
+    public:
+        using Index = QueryResults::Index;
+
+        // the maximum number of children of each node
+        static constexpr std::size_t fanout = 16;
+
+        RTree() = default;
+
+        // the rectangles are identified by their indices
+        explicit RTree(Rectangles const& rectangles);
+
+        auto empty() const noexcept
+        {
+            return num_rectangles==0;
+        }
+
+        auto size() const noexcept
+        {
+            return num_rectangles;
+        }
+
+        // returns the rectangles which contain point, in ascending order
+        std::vector<Index> containing(Point point) const;
+
+        // returns the rectangles which overlap window with positive area, in ascending order
+        std::vector<Index> overlapping(Rectangle const& window) const;
+
+        // returns the k rectangles nearest to point in ascending order of distance and then of index;
+        // a rectangle which contains the point is at distance zero
+        std::vector<Index> nearest(Point point, std::size_t k) const;
+
+        // as containing, for each of points;
+        // probes which reach the same node are tested against its children together
+        QueryResults containing(std::vector<Point> const& points) const;
+
+        // as overlapping, for each of windows;
+        // probes which reach the same node are tested against its children together
+        QueryResults overlapping(Rectangles const& windows) const;
+
+    private:
+        // the bounds of each child and the node or rectangle which it is;
+        // unused children have bounds which contain and overlap nothing
+        struct alignas(64) Node {
+            int x0s[fanout];
+            int x1s[fanout];
+            int y0s[fanout];
+            int y1s[fanout];
+            Index children[fanout];
+            std::uint32_t num_children;
+        };
+
+        // helper function of the single queries
+        template<typename Probe>
+        std::vector<Index> search(Probe const& probe) const;
+
+        // helper function of the batched queries
+        template<typename Probe>
+        QueryResults batch(std::vector<Probe> const& probes) const;
+
+        // the children of nodes below num_leaves are rectangles; the root is the last node
+        std::vector<Node, ArenaAllocator<Node, alignof(Node)>> nodes;
+        std::size_t num_leaves = 0;
+        std::size_t num_rectangles = 0;
+    };
+}
+
+#endif //INTERSECTIONS_RTREE_H
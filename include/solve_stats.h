@@ -0,0 +1,132 @@
+/// \file
+/// \brief definition of intersections::SolveStats, which reports where the time of a call to solve went
+
+#ifndef INTERSECTIONS_SOLVE_STATS_H
+#define INTERSECTIONS_SOLVE_STATS_H
+
+#include <arena.h>
+
+#include <chrono>
+#include <cstddef>
+
+namespace intersections {
+    // counters and timings of calls to solve, filled in when SolveOptions::stats points to one;
+    // they are only recorded if the library is built with INTERSECTIONS_STATS defined
+    // and otherwise the recording compiles to nothing and they stay zero;
+    // each call adds to the values so one SolveStats can total several calls
+    struct SolveStats {
+        struct Counters {
+            // the ranges visited by the vertical sweeps of the fast solutions
+            std::size_t sweep_callbacks = 0;
+
+            // the areas of overlap which were found but not reported
+            // because they are reported by another range, combination or clique
+            std::size_t duplicates_discarded = 0;
+
+            // the lookups of the results map by the overload of solve which returns Intersections
+            std::size_t hash_probes = 0;
+
+            // the steps of the recursions of the simple and cliques solutions
+            // and how many of them stopped early because no overlap below them could be within the limits
+            std::size_t recursion_nodes = 0;
+            std::size_t recursion_pruned = 0;
+
+            // the working memory taken from arenas
+            std::size_t bytes_allocated = 0;
+
+            Counters& operator+=(Counters const& that) noexcept
+            {
+                sweep_callbacks += that.sweep_callbacks;
+                duplicates_discarded += that.duplicates_discarded;
+                hash_probes += that.hash_probes;
+                recursion_nodes += that.recursion_nodes;
+                recursion_pruned += that.recursion_pruned;
+                bytes_allocated += that.bytes_allocated;
+                return *this;
+            }
+        };
+
+        Counters counts;
+
+        // the wall time spent building the structures which are searched,
+        // searching them and, for the solutions which search in parallel, reporting what was found
+        double build_seconds = 0;
+        double sweep_seconds = 0;
+        double collect_seconds = 0;
+    };
+
+#if defined(INTERSECTIONS_STATS)
+    // adds n to a counter of stats unless stats is null
+    inline void record(SolveStats* const stats, std::size_t SolveStats::Counters::* const counter, std::size_t const n = 1)
+            noexcept
+    {
+        if (stats!=nullptr) {
+            stats->counts.*counter += n;
+        }
+    }
+
+    // records the time taken by consecutive phases of a call to solve
+    // and the memory which it takes from arena;
+    // does nothing if stats is null
+    class SolveRecorder {
+    public:
+        // begins the build phase
+        SolveRecorder(SolveStats* const stats, Arena const& arena) noexcept
+                :stats(stats), arena(arena), first_allocated(arena.allocated()), start(Clock::now())
+        {
+        }
+
+        SolveRecorder(SolveRecorder const&) = delete;
+
+        SolveRecorder& operator=(SolveRecorder const&) = delete;
+
+        // ends the current phase and begins the given one
+        void begin(double SolveStats::* const next_phase) noexcept
+        {
+            auto const now = Clock::now();
+            if (stats!=nullptr) {
+                stats->*phase += std::chrono::duration<double>(now-start).count();
+            }
+            phase = next_phase;
+            start = now;
+        }
+
+        ~SolveRecorder()
+        {
+            begin(phase);
+            record(stats, &SolveStats::Counters::bytes_allocated, arena.allocated()-first_allocated);
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        SolveStats* stats;
+        Arena const& arena;
+        std::size_t first_allocated;
+
+        double SolveStats::* phase = &SolveStats::build_seconds;
+        Clock::time_point start;
+    };
+#else
+    inline void record(SolveStats*, std::size_t SolveStats::Counters::*, std::size_t = 1) noexcept
+    {
+    }
+
+    class SolveRecorder {
+    public:
+        SolveRecorder(SolveStats*, Arena const&) noexcept
+        {
+        }
+
+        SolveRecorder(SolveRecorder const&) = delete;
+
+        SolveRecorder& operator=(SolveRecorder const&) = delete;
+
+        void begin(double SolveStats::*) noexcept
+        {
+        }
+    };
+#endif
+}
+
+#endif //INTERSECTIONS_SOLVE_STATS_H
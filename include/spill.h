@@ -0,0 +1,49 @@
+/// \file
+/// \brief declaration of intersections::solve_sorted, which sorts results within a memory budget
+
+#ifndef INTERSECTIONS_SPILL_H
+#define INTERSECTIONS_SPILL_H
+
+#include <intersections.h>
+
+#include <cstddef>
+#include <string>
+
+namespace intersections {
+    // limits on the memory used by solve_sorted to hold results
+    struct SpillOptions {
+        // once the results held in memory would exceed this many bytes, they are sorted and written to disk;
+        // must be enough to hold the largest single result;
+        // the buffer of results grows as they arrive, briefly holding its old and new storage as it does,
+        // and is the only memory this bounds: not the working memory of the solver,
+        // nor the record of each run held while the runs are merged,
+        // nor the results which the fast_parallel and tiled solutions hold before reporting them
+        std::size_t memory_budget = std::size_t{256} << 20;
+
+        // the directory to which results are written or, if empty, the system's temporary directory
+        std::string directory;
+    };
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap within the limits of options,
+    // in order of area of overlap, as found by solver;
+    // results which exceed spill.memory_budget are written to disk in sorted runs of compact binary records
+    // which are merged, and duplicates removed, once solver returns;
+    // the runs are deleted before returning;
+    // throws std::runtime_error if a run cannot be written or read
+    void solve_sorted(
+            Rectangles const& rectangles, Visitor const& visitor,
+            void (* solver)(Rectangles const&, Visitor const&, SolveOptions const&, Arena&),
+            SpillOptions const& spill, SolveOptions const& options = SolveOptions{});
+
+    // given a set of rectangles, call visitor once for each distinct area of overlap within the limits of options,
+    // in order of area of overlap, buffering no more than spill.memory_budget bytes of results in memory
+    template<Solution solution>
+    void solve_sorted(
+            Rectangles const& rectangles, Visitor const& visitor, SpillOptions const& spill,
+            SolveOptions const& options = SolveOptions{})
+    {
+        solve_sorted(rectangles, visitor, solve<solution>, spill, options);
+    }
+}
+
+#endif //INTERSECTIONS_SPILL_H
@@ -0,0 +1,37 @@
+/// \file
+/// \brief defines intersections::solve<Solution::automatic>
+
+#include <cost_model.h>
+
+using namespace intersections;
+
+namespace intersections {
+    template<>
+    void solve<Solution::automatic>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        switch (cost_model().choose(measure(rectangles))) {
+            case Solution::simple:
+                solve<Solution::simple>(rectangles, visitor, options, arena);
+                break;
+            case Solution::fast:
+                solve<Solution::fast>(rectangles, visitor, options, arena);
+                break;
+            case Solution::fast_parallel:
+                solve<Solution::fast_parallel>(rectangles, visitor, options, arena);
+                break;
+            case Solution::tiled:
+                solve<Solution::tiled>(rectangles, visitor, options, arena);
+                break;
+            case Solution::cliques:
+                solve<Solution::cliques>(rectangles, visitor, options, arena);
+                break;
+            case Solution::grid:
+                solve<Solution::grid>(rectangles, visitor, options, arena);
+                break;
+            case Solution::automatic:
+                assert(false);
+                break;
+        }
+    }
+}
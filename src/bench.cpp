@@ -0,0 +1,480 @@
+/// \file
+/// \brief benchmark tool times each solution over named workloads of increasing size
+
+#include <cliques.h>
+#include <cost_model.h>
+#include <grid.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace intersections;
+
+namespace {
+    ////////////////////////////////////////////////////////////////////////////////
+    // workloads
+
+    // std::mt19937 produces the same sequence everywhere but the standard distributions do not,
+    // so positions are drawn from it directly in order that a seed gives the same rectangles everywhere
+    class Random {
+    public:
+        explicit Random(std::seed_seq& seeds)
+                :gen(seeds)
+        {
+        }
+
+        // returns a number in [first, last]
+        int operator()(int const first, int const last)
+        {
+            assert(first<=last);
+            auto const range = std::uint64_t(std::int64_t(last)-first+1);
+            return int(first+std::int64_t((range*std::uint32_t(gen())) >> 32));
+        }
+
+    private:
+        std::mt19937 gen;
+    };
+
+    // returns the rectangle with corners at the given positions in either order
+    Rectangle between(int const x0, int const y0, int const x1, int const y1) noexcept
+    {
+        return Rectangle::from_intervals(
+                Interval{std::min(x0, x1), std::max(x0, x1)+1}, Interval{std::min(y0, y1), std::max(y0, y1)+1});
+    }
+
+    // edges spread evenly over [0, 250], as used for the tables in README.md
+    Rectangles uniform(Random& random, int const num_rectangles)
+    {
+        Rectangles rectangles;
+        while (int(rectangles.size())!=num_rectangles) {
+            rectangles.push_back(between(random(0, 249), random(0, 249), random(0, 249), random(0, 249)));
+        }
+        return rectangles;
+    }
+
+    // small rectangles gathered around a few centres in a large area
+    Rectangles clustered(Random& random, int const num_rectangles)
+    {
+        constexpr auto num_clusters = 8;
+        int centres[num_clusters][2];
+        for (auto& centre : centres) {
+            centre[0] = random(0, 10000);
+            centre[1] = random(0, 10000);
+        }
+
+        Rectangles rectangles;
+        while (int(rectangles.size())!=num_rectangles) {
+            auto const& centre = centres[random(0, num_clusters-1)];
+            auto const x = centre[0]+random(-200, 200);
+            auto const y = centre[1]+random(-200, 200);
+            rectangles.push_back(Rectangle{x, y, random(1, 100), random(1, 100)});
+        }
+        return rectangles;
+    }
+
+    // long, thin rectangles, alternately horizontal and vertical
+    Rectangles slivers(Random& random, int const num_rectangles)
+    {
+        Rectangles rectangles;
+        while (int(rectangles.size())!=num_rectangles) {
+            auto const length = random(100, 1000);
+            auto const thickness = random(1, 4);
+            auto const is_horizontal = rectangles.size()%2==0;
+            rectangles.push_back(Rectangle{
+                    random(0, 1000), random(0, 1000),
+                    is_horizontal ? length : thickness, is_horizontal ? thickness : length});
+        }
+        return rectangles;
+    }
+
+    // rectangles inside one another with slightly jittered centres
+    Rectangles nested(Random& random, int const num_rectangles)
+    {
+        Rectangles rectangles;
+        for (auto n = 0; n!=num_rectangles; ++n) {
+            auto const half_extent = (num_rectangles-n)*8;
+            auto const x = random(-2, 2);
+            auto const y = random(-2, 2);
+            rectangles.push_back(between(x-half_extent, y-half_extent, x+half_extent, y+half_extent));
+        }
+        return rectangles;
+    }
+
+    // rectangles whose edges lie on a coarse grid of 21 lines in each direction
+    Rectangles grid_aligned(Random& random, int const num_rectangles)
+    {
+        Rectangles rectangles;
+        while (int(rectangles.size())!=num_rectangles) {
+            auto const x0 = random(0, 20)*10;
+            auto const y0 = random(0, 20)*10;
+            auto const x1 = random(0, 20)*10;
+            auto const y1 = random(0, 20)*10;
+            if (x0!=x1 && y0!=y1) {
+                rectangles.push_back(Rectangle::from_intervals(
+                        Interval{std::min(x0, x1), std::max(x0, x1)}, Interval{std::min(y0, y1), std::max(y0, y1)}));
+            }
+        }
+        return rectangles;
+    }
+
+    // small rectangles spread so thinly that each overlaps about one other
+    Rectangles sparse_huge(Random& random, int const num_rectangles)
+    {
+        auto const spread = int(std::sqrt(double(num_rectangles))*60);
+        Rectangles rectangles;
+        while (int(rectangles.size())!=num_rectangles) {
+            rectangles.push_back(Rectangle{random(0, spread), random(0, spread), random(1, 40), random(1, 40)});
+        }
+        return rectangles;
+    }
+
+    struct Generator {
+        char const* name;
+        Rectangles (* generate)(Random& random, int num_rectangles);
+
+        // the largest number of rectangles in the default sweep
+        int max_rectangles;
+    };
+
+    constexpr Generator generators[] = {
+            {"uniform",      uniform,      1024},
+            {"clustered",    clustered,    4096},
+            {"slivers",      slivers,      4096},
+            {"nested",       nested,       256},
+            {"grid_aligned", grid_aligned, 4096},
+            {"sparse_huge",  sparse_huge,  1 << 20}};
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // measurement
+
+    using Solver = void (*)(Rectangles const&, Visitor const&, SolveOptions const&, Arena&);
+
+    constexpr Solver solvers[] = {
+            solve<Solution::simple>,
+            solve<Solution::fast>,
+            solve<Solution::fast_parallel>,
+            solve<Solution::tiled>,
+            solve<Solution::cliques>,
+            solve<Solution::grid>,
+            solve<Solution::automatic>};
+
+    // starts a new measurement of peak memory by resetting the peak resident set size of the process
+    // to its current size; returns false if this is not supported, as it is only on Linux
+    bool reset_peak_rss() noexcept
+    {
+#if defined(__linux__)
+        auto const file = std::fopen("/proc/self/clear_refs", "w");
+        if (file==nullptr) {
+            return false;
+        }
+        auto const is_written = std::fputs("5", file)>=0;
+        return (std::fclose(file)==0) && is_written;
+#else
+        return false;
+#endif
+    }
+
+    // returns the peak resident set size of the process since it was last reset, in kilobytes, or -1 if it is unknown
+    long peak_rss_kilobytes() noexcept
+    {
+        auto kilobytes = -1L;
+#if defined(__linux__)
+        auto const file = std::fopen("/proc/self/status", "r");
+        if (file==nullptr) {
+            return kilobytes;
+        }
+        char line[256];
+        while (std::fgets(line, sizeof(line), file)!=nullptr) {
+            if (std::sscanf(line, "VmHWM: %ld kB", &kilobytes)==1) {
+                break;
+            }
+        }
+        std::fclose(file);
+#endif
+        return kilobytes;
+    }
+
+    // the times of the runs of one solution over one set of rectangles
+    struct Measurement {
+        std::size_t num_results;
+        double median_seconds;
+        double p95_seconds;
+        long peak_rss_kilobytes;
+    };
+
+    // returns the value below which the given fraction of the sorted values lie
+    double percentile(std::vector<double> const& sorted, double const fraction) noexcept
+    {
+        assert(!sorted.empty());
+        auto const index = std::size_t(std::ceil(fraction*double(sorted.size())))-1;
+        return sorted[std::min(index, sorted.size()-1)];
+    }
+
+    // times the runs of solver and measures the peak memory of the process while they run;
+    // each measurement has its own arena so that memory kept by earlier solutions is not resident
+    Measurement time_runs(Solver const solver, Rectangles const& rectangles, int const num_repeats)
+    {
+        Arena arena;
+        auto num_results = std::size_t{0};
+        auto const visitor = [&num_results](Rectangle const&, RectangleSequence const&) {
+            ++num_results;
+        };
+
+        std::vector<double> seconds;
+        auto const is_peak_reset = reset_peak_rss();
+        for (auto repeat = 0; repeat!=num_repeats; ++repeat) {
+            num_results = 0;
+            auto const start = std::chrono::steady_clock::now();
+            solver(rectangles, visitor, SolveOptions{}, arena);
+            auto const finish = std::chrono::steady_clock::now();
+            seconds.push_back(std::chrono::duration<double>(finish-start).count());
+        }
+        std::sort(std::begin(seconds), std::end(seconds));
+
+        return Measurement{
+                num_results, percentile(seconds, .5), percentile(seconds, .95),
+                is_peak_reset ? peak_rss_kilobytes() : -1};
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // command line
+
+    struct Settings {
+        std::vector<std::size_t> workloads;
+        std::vector<Solution> solutions;
+
+        // if empty, each workload sweeps powers of two from 8 to its max_rectangles
+        std::vector<int> sizes;
+
+        int num_repeats = 5;
+        unsigned seed = 1;
+
+        // a solution is not run on larger sets of rectangles of a workload
+        // once the median predicted for the next size exceeds this
+        double max_seconds = 2.;
+
+        bool is_json = false;
+
+        // if not null, a cost model fitted to the measurements is saved here
+        char const* calibration_filename = nullptr;
+    };
+
+    // splits a comma-separated list
+    std::vector<std::string> split(char const* const list)
+    {
+        std::vector<std::string> items(1);
+        for (auto c = list; *c!='\0'; ++c) {
+            if (*c==',') {
+                items.emplace_back();
+            }
+            else {
+                items.back() += *c;
+            }
+        }
+        return items;
+    }
+
+    void print_usage()
+    {
+        std::puts(
+                "usage: bench [options]\n"
+                "  --workloads LIST    comma-separated subset of uniform, clustered, slivers, nested,\n"
+                "                      grid_aligned and sparse_huge (default: all)\n"
+                "  --solutions LIST    comma-separated subset of simple, fast, fast_parallel, tiled,\n"
+                "                      cliques, grid and automatic (default: all)\n"
+                "  --sizes LIST        comma-separated numbers of rectangles (default: powers of two)\n"
+                "  --repeats N         runs of each measurement (default: 5)\n"
+                "  --seed N            seed of the generated rectangles (default: 1)\n"
+                "  --max-seconds T     stop growing a solution's workload before a median of T (default: 2)\n"
+                "  --format csv|json   output format (default: csv)\n"
+                "  --calibrate FILE    fit a cost model to the measurements and save it to FILE");
+    }
+
+    // returns false if the arguments are invalid
+    bool parse(int const argc, char** const argv, Settings& settings)
+    {
+        for (auto n = 1; n<argc; n += 2) {
+            auto const option = argv[n];
+            if (n+1==argc) {
+                return false;
+            }
+            auto const value = argv[n+1];
+
+            if (std::strcmp(option, "--workloads")==0) {
+                for (auto const& name : split(value)) {
+                    auto const found = std::find_if(std::begin(generators), std::end(generators), [&](auto const& generator) {
+                        return name==generator.name;
+                    });
+                    if (found==std::end(generators)) {
+                        return false;
+                    }
+                    settings.workloads.push_back(std::size_t(found-std::begin(generators)));
+                }
+            }
+            else if (std::strcmp(option, "--solutions")==0) {
+                for (auto const& name : split(value)) {
+                    auto solution = Solution{};
+                    if (!from_string(name.c_str(), solution)) {
+                        return false;
+                    }
+                    settings.solutions.push_back(solution);
+                }
+            }
+            else if (std::strcmp(option, "--sizes")==0) {
+                for (auto const& size : split(value)) {
+                    settings.sizes.push_back(std::atoi(size.c_str()));
+                    if (settings.sizes.back()<=0) {
+                        return false;
+                    }
+                }
+            }
+            else if (std::strcmp(option, "--repeats")==0) {
+                settings.num_repeats = std::atoi(value);
+                if (settings.num_repeats<=0) {
+                    return false;
+                }
+            }
+            else if (std::strcmp(option, "--seed")==0) {
+                settings.seed = unsigned(std::strtoul(value, nullptr, 10));
+            }
+            else if (std::strcmp(option, "--max-seconds")==0) {
+                settings.max_seconds = std::atof(value);
+            }
+            else if (std::strcmp(option, "--format")==0) {
+                if (std::strcmp(value, "json")!=0 && std::strcmp(value, "csv")!=0) {
+                    return false;
+                }
+                settings.is_json = std::strcmp(value, "json")==0;
+            }
+            else if (std::strcmp(option, "--calibrate")==0) {
+                settings.calibration_filename = value;
+            }
+            else {
+                return false;
+            }
+        }
+
+        if (settings.workloads.empty()) {
+            for (auto n = std::size_t{0}; n!=std::size_t(std::end(generators)-std::begin(generators)); ++n) {
+                settings.workloads.push_back(n);
+            }
+        }
+        if (settings.solutions.empty()) {
+            for (auto n = std::size_t{0}; n!=num_engines+1; ++n) {
+                settings.solutions.push_back(Solution(n));
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    auto settings = Settings{};
+    if (!parse(argc, argv, settings)) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::puts(settings.is_json
+              ? "["
+              : "workload,rectangles,solution,repeats,median_seconds,p95_seconds,results,results_per_second,"
+                "peak_rss_kilobytes");
+
+    std::vector<CostModel::Sample> samples;
+    auto is_first_row = true;
+    for (auto const workload_index : settings.workloads) {
+        auto const& generator = generators[workload_index];
+        auto sizes = settings.sizes;
+        if (sizes.empty()) {
+            for (auto size = 8; size<=generator.max_rectangles; size *= 2) {
+                sizes.push_back(size);
+            }
+        }
+
+        // the median of each solution at the last size it was run, or zero if it is still run
+        std::vector<double> stopped_seconds(settings.solutions.size(), 0.);
+
+        // the median of each solution at the previous size, or zero if it has not been run
+        std::vector<double> previous_seconds(settings.solutions.size(), 0.);
+        for (auto const num_rectangles : sizes) {
+            // Generate the same rectangles for the same seed, workload and size
+            std::seed_seq seeds{settings.seed, unsigned(workload_index), unsigned(num_rectangles)};
+            auto random = Random(seeds);
+            auto const rectangles = generator.generate(random, num_rectangles);
+            auto const features = measure(rectangles);
+
+            for (auto n = std::size_t{0}; n!=settings.solutions.size(); ++n) {
+                auto const solution = settings.solutions[n];
+
+                // and time each solution which has not been stopped
+                if (stopped_seconds[n]!=0) {
+                    continue;
+                }
+                if ((solution==Solution::grid && !grid_fits(rectangles))
+                        || (solution==Solution::cliques && !cliques_fit(rectangles))) {
+                    continue;
+                }
+                auto const measurement = time_runs(solvers[std::size_t(solution)], rectangles, settings.num_repeats);
+
+                // The time of simple grows exponentially with depth, so the next time is predicted by
+                // squaring the growth since the previous size, which is exact for exponential growth
+                // and errs on the side of stopping early for polynomial growth.
+                auto const growth = previous_seconds[n]>0
+                                    ? std::max(1., measurement.median_seconds/previous_seconds[n])
+                                    : 1.;
+                if (measurement.median_seconds*growth*growth>settings.max_seconds) {
+                    stopped_seconds[n] = measurement.median_seconds;
+                }
+                previous_seconds[n] = measurement.median_seconds;
+                if (solution!=Solution::automatic) {
+                    samples.push_back(CostModel::Sample{solution, features, measurement.median_seconds});
+                }
+
+                // Finally, report the measurement.
+                auto const results_per_second = double(measurement.num_results)/measurement.median_seconds;
+                if (settings.is_json) {
+                    std::printf(
+                            "%s  {\"workload\": \"%s\", \"rectangles\": %d, \"solution\": \"%s\", \"repeats\": %d, "
+                            "\"median_seconds\": %.9g, \"p95_seconds\": %.9g, \"results\": %zu, "
+                            "\"results_per_second\": %.9g, \"peak_rss_kilobytes\": %ld}",
+                            is_first_row ? "" : ",\n", generator.name, num_rectangles, to_string(solution),
+                            settings.num_repeats, measurement.median_seconds, measurement.p95_seconds,
+                            measurement.num_results, results_per_second, measurement.peak_rss_kilobytes);
+                }
+                else {
+                    std::printf(
+                            "%s,%d,%s,%d,%.9g,%.9g,%zu,%.9g,%ld\n",
+                            generator.name, num_rectangles, to_string(solution), settings.num_repeats,
+                            measurement.median_seconds, measurement.p95_seconds, measurement.num_results,
+                            results_per_second, measurement.peak_rss_kilobytes);
+                }
+                std::fflush(stdout);
+                is_first_row = false;
+            }
+        }
+    }
+    if (settings.is_json) {
+        std::puts("\n]");
+    }
+
+    if (settings.calibration_filename!=nullptr) {
+        auto model = CostModel{};
+        model.fit(samples);
+        if (!model.save(settings.calibration_filename)) {
+            std::fprintf(stderr, "error saving cost model file, \"%s\"\n", settings.calibration_filename);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+/// \file
+/// \brief definition of intersections::Bitset, intersections::RectangleBitset and related functions
+
+#ifndef INTERSECTIONS_BITSET_H
+#define INTERSECTIONS_BITSET_H
+
+#include <arena.h>
+#include <rectangle.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace intersections {
+    // returns the index of the lowest set bit of a non-zero word
+    inline int count_trailing_zeros(std::uint64_t const word) noexcept
+    {
+        assert(word!=0);
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return int(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    // returns the number of set bits in a word
+    inline int popcount(std::uint64_t const word) noexcept
+    {
+#if defined(_MSC_VER)
+        return int(__popcnt64(word));
+#else
+        return __builtin_popcountll(word);
+#endif
+    }
+
+    // fixed-size sequence of bits whose size is chosen at run-time;
+    // memory is allocated from an optional Arena which is shared by copies
+    class Bitset {
+    public:
+        using Word = std::uint64_t;
+
+        static constexpr auto bits_per_word = 64;
+
+        // iterates over the indices of set bits in ascending order
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type const*;
+            using reference = value_type;
+
+            const_iterator() = default;
+
+            const_iterator(Word const* first, Word const* word, Word const* last) noexcept
+                    :first(first), word(word), last(last), remaining((word!=last) ? *word : 0)
+            {
+                skip_empty_words();
+            }
+
+            reference operator*() const noexcept
+            {
+                return std::size_t(word-first)*bits_per_word+count_trailing_zeros(remaining);
+            }
+
+            const_iterator& operator++() noexcept
+            {
+                // clear the lowest set bit
+                remaining &= remaining-1;
+                skip_empty_words();
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept
+            {
+                auto const previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return lhs.word==rhs.word && lhs.remaining==rhs.remaining;
+            }
+
+            friend bool operator!=(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return !(lhs==rhs);
+            }
+
+        private:
+            void skip_empty_words() noexcept
+            {
+                while (remaining==0 && word!=last) {
+                    ++word;
+                    remaining = (word!=last) ? *word : 0;
+                }
+            }
+
+            Word const* first = nullptr;
+            Word const* word = nullptr;
+            Word const* last = nullptr;
+            Word remaining = 0;
+        };
+
+        Bitset() = default;
+
+        explicit Bitset(std::size_t num_bits, Arena* arena = nullptr)
+                :words((num_bits+bits_per_word-1)/bits_per_word, Word{0}, arena)
+        {
+        }
+
+        Bitset(Bitset const& that)
+                :words(that.words, that.words.get_allocator())
+        {
+        }
+
+        Bitset& operator=(Bitset const&) = default;
+
+        Arena* arena() const noexcept
+        {
+            return words.get_allocator().arena();
+        }
+
+        auto num_words() const noexcept
+        {
+            return words.size();
+        }
+
+        Word const* data() const noexcept
+        {
+            return words.data();
+        }
+
+        Word* data() noexcept
+        {
+            return words.data();
+        }
+
+        bool test(std::size_t index) const noexcept
+        {
+            assert(index/bits_per_word<words.size());
+            return (words[index/bits_per_word] >> (index%bits_per_word)) & 1;
+        }
+
+        // sets the bit at index and returns true iff it was previously clear
+        bool set(std::size_t index) noexcept
+        {
+            assert(index/bits_per_word<words.size());
+            auto& word = words[index/bits_per_word];
+            auto const mask = Word{1} << (index%bits_per_word);
+            auto const was_clear = (word & mask)==0;
+            word |= mask;
+            return was_clear;
+        }
+
+        // clears the bit at index and returns true iff it was previously set
+        bool reset(std::size_t index) noexcept
+        {
+            assert(index/bits_per_word<words.size());
+            auto& word = words[index/bits_per_word];
+            auto const mask = Word{1} << (index%bits_per_word);
+            auto const was_set = (word & mask)!=0;
+            word &= ~mask;
+            return was_set;
+        }
+
+        void clear() noexcept
+        {
+            std::fill(std::begin(words), std::end(words), Word{0});
+        }
+
+        // returns the number of set bits
+        int count() const noexcept
+        {
+            auto total = 0;
+            for (auto const word : words) {
+                total += popcount(word);
+            }
+            return total;
+        }
+
+        auto begin() const noexcept
+        {
+            return const_iterator(words.data(), words.data(), words.data()+words.size());
+        }
+
+        auto end() const noexcept
+        {
+            auto const last = words.data()+words.size();
+            return const_iterator(words.data(), last, last);
+        }
+
+        friend bool operator==(Bitset const& lhs, Bitset const& rhs) noexcept
+        {
+            return lhs.words==rhs.words;
+        }
+
+        friend bool operator!=(Bitset const& lhs, Bitset const& rhs) noexcept
+        {
+            return !(lhs==rhs);
+        }
+
+    private:
+        ArenaVector<Word> words;
+    };
+
+    // set of rectangles from a contiguous sequence, represented as one bit per rectangle;
+    // iterates over rectangles in sequence order
+    class RectangleBitset {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Rectangle const*;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type const*;
+            using reference = value_type;
+
+            const_iterator() = default;
+
+            const_iterator(Rectangle const* first, Bitset::const_iterator index) noexcept
+                    :first(first), index(index)
+            {
+            }
+
+            reference operator*() const noexcept
+            {
+                return first+*index;
+            }
+
+            const_iterator& operator++() noexcept
+            {
+                ++index;
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept
+            {
+                auto const previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return lhs.index==rhs.index;
+            }
+
+            friend bool operator!=(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return !(lhs==rhs);
+            }
+
+        private:
+            Rectangle const* first = nullptr;
+            Bitset::const_iterator index;
+        };
+
+        RectangleBitset() = default;
+
+        // an empty set which can hold any of the num_rectangles rectangles beginning at first
+        RectangleBitset(Rectangle const* first, std::size_t num_rectangles, Arena* arena = nullptr)
+                :first(first), bits(num_rectangles, arena)
+        {
+        }
+
+        Arena* arena() const noexcept
+        {
+            return bits.arena();
+        }
+
+        auto empty() const noexcept
+        {
+            return num_rectangles==0;
+        }
+
+        auto size() const noexcept
+        {
+            return num_rectangles;
+        }
+
+        bool contains(Rectangle const* rectangle) const noexcept
+        {
+            return bits.test(index_of(rectangle));
+        }
+
+        // returns true iff rectangle was not already in the set
+        bool insert(Rectangle const* rectangle) noexcept
+        {
+            auto const inserted = bits.set(index_of(rectangle));
+            num_rectangles += inserted;
+            return inserted;
+        }
+
+        // returns true iff rectangle was in the set
+        bool erase(Rectangle const* rectangle) noexcept
+        {
+            auto const erased = bits.reset(index_of(rectangle));
+            num_rectangles -= erased;
+            return erased;
+        }
+
+        auto begin() const noexcept
+        {
+            return const_iterator(first, std::begin(bits));
+        }
+
+        auto end() const noexcept
+        {
+            return const_iterator(first, std::end(bits));
+        }
+
+    private:
+        std::size_t index_of(Rectangle const* rectangle) const noexcept
+        {
+            assert(rectangle>=first);
+            return std::size_t(rectangle-first);
+        }
+
+        Rectangle const* first = nullptr;
+        Bitset bits;
+        int num_rectangles = 0;
+    };
+}
+
+#endif //INTERSECTIONS_BITSET_H
@@ -0,0 +1,197 @@
+/// \file
+/// \brief defines intersections::solve<Solution::cliques>
+
+#include <cliques.h>
+#include <depth.h>
+#include <rectangle_batch.h>
+
+#include "bitset.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace intersections;
+
+namespace {
+    constexpr auto bits_per_word = RectangleBatch::rectangles_per_word;
+
+    // state which is common to every step of the enumeration of intersections::solve<Solution::cliques>
+    struct Enumeration {
+        Rectangles const& rectangles;
+
+        // row n holds the rectangles which overlap rectangle n
+        std::vector<std::uint64_t> const& adjacency;
+        std::size_t num_words;
+
+        // two sets of num_words words for each level of the enumeration
+        ArenaVector<std::uint64_t>& sets;
+
+        RectangleSequence& constituents;
+        Visitor const& visitor;
+        SolveOptions const& options;
+
+        // the number of overlaps reported so far
+        std::size_t num_results;
+    };
+
+    // returns the number of bytes in the bitsets for num_rectangles rectangles
+    // which are enumerated to the given depth;
+    // saturates rather than overflowing
+    std::size_t cliques_bytes(std::size_t const num_rectangles, std::size_t const depth) noexcept
+    {
+        auto const bytes_per_set = (num_rectangles+bits_per_word-1)/bits_per_word*sizeof(std::uint64_t);
+        auto const num_sets = num_rectangles+(depth+1)*2;
+        if (bytes_per_set!=0 && num_sets>std::numeric_limits<std::size_t>::max()/bytes_per_set) {
+            return std::numeric_limits<std::size_t>::max();
+        }
+        return num_sets*bytes_per_set;
+    }
+
+    // returns a mask of the bits of word n which come after bit index
+    std::uint64_t mask_after(std::size_t const n, std::size_t const index) noexcept
+    {
+        auto const word = index/bits_per_word;
+        if (n!=word) {
+            return (n<word) ? 0 : ~std::uint64_t{0};
+        }
+        auto const bit = std::uint64_t{1} << (index%bits_per_word);
+        return ~(bit | (bit-1));
+    }
+
+    // helper function for intersections::solve<Solution::cliques>;
+    // members are the rectangles which contain overlap
+    // and candidates are the other rectangles which overlap it;
+    // the members are extended by candidates from core onwards
+    void extend(
+            Enumeration& enumeration, std::size_t const depth, std::uint64_t const* const members,
+            std::uint64_t const* const candidates, Rectangle const overlap, std::size_t const core)
+    {
+        auto const num_words = enumeration.num_words;
+        auto const& rectangles = enumeration.rectangles;
+        auto const& options = enumeration.options;
+        auto const next_members = enumeration.sets.data()+depth*2*num_words;
+        auto const next_candidates = next_members+num_words;
+
+        // For each candidate from core onwards, extend the set of members by the candidate
+        for (auto word = core/bits_per_word; word<num_words; ++word) {
+            auto const first_bits = (word==core/bits_per_word) ? ~std::uint64_t{0} << (core%bits_per_word)
+                                                                : ~std::uint64_t{0};
+            for (auto remaining = candidates[word] & first_bits; remaining!=0; remaining &= remaining-1) {
+                if (enumeration.num_results>=options.max_results) {
+                    return;
+                }
+                record(options.stats, &SolveStats::Counters::recursion_nodes);
+
+                // and by every other rectangle which contains their overlap;
+                // it is the candidates which overlap the extension that may contain it
+                auto const extension_bit = remaining & -remaining;
+                auto const extension = word*bits_per_word+count_trailing_zeros(remaining);
+                auto const& extension_rectangle = rectangles[extension];
+                auto const next_overlap = overlap & extension_rectangle;
+                if (std::int64_t(next_overlap.w())*next_overlap.h()<options.min_area) {
+                    record(options.stats, &SolveStats::Counters::recursion_pruned);
+                    continue;
+                }
+
+                // The set is only extended here if it gains no rectangle before the extension
+                // as it is otherwise found by extending with the earlier rectangle.
+                assert((depth+1)*2*num_words<=enumeration.sets.size());
+                auto const adjacent = enumeration.adjacency.data()+extension*num_words;
+                auto is_first = true;
+                auto num_members = std::size_t{0};
+                auto num_candidates = std::size_t{0};
+                for (auto w = std::size_t{0}; w!=num_words && is_first; ++w) {
+                    auto containing = std::uint64_t{0};
+                    for (auto others = candidates[w] & adjacent[w]; others!=0; others &= others-1) {
+                        auto const other = w*bits_per_word+count_trailing_zeros(others);
+                        if (contains(rectangles[other], next_overlap)) {
+                            containing |= others & -others;
+                        }
+                    }
+
+                    auto const after_extension = mask_after(w, extension);
+                    is_first = (containing & ~after_extension)==0;
+
+                    next_members[w] = members[w] | containing | ((w==word) ? extension_bit : 0);
+                    next_candidates[w] = candidates[w] & adjacent[w] & ~containing;
+
+                    // only rectangles after the extension can join later extensions
+                    num_members += popcount(next_members[w]);
+                    num_candidates += popcount(next_candidates[w] & after_extension);
+                }
+                if (!is_first) {
+                    record(options.stats, &SolveStats::Counters::duplicates_discarded);
+                    continue;
+                }
+                if (num_members+num_candidates<options.min_constituents) {
+                    record(options.stats, &SolveStats::Counters::recursion_pruned);
+                    continue;
+                }
+
+                // Report the rectangles which overlap
+                if (num_members>=options.min_constituents) {
+                    auto& constituents = enumeration.constituents;
+                    constituents.clear();
+                    for (auto w = std::size_t{0}; w!=num_words; ++w) {
+                        for (auto bits = next_members[w]; bits!=0; bits &= bits-1) {
+                            constituents.push_back(&rectangles[w*bits_per_word+count_trailing_zeros(bits)]);
+                        }
+                    }
+                    enumeration.visitor(next_overlap, constituents);
+                    ++enumeration.num_results;
+                }
+
+                // and extend the set further.
+                extend(enumeration, depth+1, next_members, next_candidates, next_overlap, extension+1);
+            }
+        }
+    }
+}
+
+namespace intersections {
+    std::size_t cliques_bytes(Rectangles const& rectangles)
+    {
+        return ::cliques_bytes(rectangles.size(), std::size_t(max_depth(rectangles).depth));
+    }
+
+    template<>
+    void solve<Solution::cliques>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        Arena::Scope const scope(&arena);
+        SolveRecorder recorder(options.stats, arena);
+        if (rectangles.empty()) {
+            return;
+        }
+
+        // The members of a set all overlap at a point so the enumeration is no deeper than the deepest point.
+        auto const depth = std::size_t(max_depth(rectangles).depth);
+        if (::cliques_bytes(rectangles.size(), depth)>max_cliques_bytes) {
+            throw std::length_error("intersections::solve<Solution::cliques>: bitsets exceed max_cliques_bytes");
+        }
+
+        // Find which pairs of rectangles overlap.
+        auto const batch = RectangleBatch(rectangles, &arena);
+        auto const adjacency = overlap_matrix(batch);
+        auto const num_words = batch.num_words();
+
+        // reserved up-front because they must not move during the enumeration
+        RectangleSequence constituents(&arena);
+        constituents.reserve(rectangles.size());
+        ArenaVector<std::uint64_t> sets((depth+1)*2*num_words, &arena);
+
+        // Every rectangle is a candidate to begin a set.
+        auto const members = sets.data();
+        auto const candidates = members+num_words;
+        for (auto index = std::size_t{0}; index!=rectangles.size(); ++index) {
+            candidates[index/bits_per_word] |= std::uint64_t{1} << (index%bits_per_word);
+        }
+
+        auto enumeration = Enumeration{rectangles, adjacency, num_words, sets, constituents, visitor, options, 0};
+        recorder.begin(&SolveStats::sweep_seconds);
+        extend(enumeration, 1, members, candidates, maximum_rectangle, 0);
+    }
+}
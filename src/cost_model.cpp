@@ -0,0 +1,285 @@
+/// \file
+/// \brief defines intersections::CostModel and related functions
+
+#include <cliques.h>
+#include <cost_model.h>
+#include <grid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+
+using namespace intersections;
+
+namespace {
+    // the number of pairs of rectangles sampled to estimate the density of overlaps
+    constexpr std::size_t num_sampled_pairs = 4096;
+
+    // keeps the fit well-conditioned when the samples do not vary in every feature
+    constexpr auto ridge = 1e-6;
+
+    // runs faster than this are not timed reliably
+    constexpr auto min_seconds = 1e-7;
+
+    constexpr char const* names[num_engines] = {"simple", "fast", "fast_parallel", "tiled", "cliques", "grid"};
+
+    // fitted to timed runs of every solution on uniform, sparse and few-coordinate sets of up to 30,000 rectangles
+    // on a single core; a calibration on the target machine should replace them
+    constexpr CostModel::Coefficients default_coefficients[num_engines] = {
+            {-20.9, -0.1364, 0.06968, -0.01322, 3.437, 0.5001},
+            {-18.18, -0.832, 0.04293, -0.005089, 1.764, 0.8373},
+            {-16.61, -1.174, 0.06189, -0.003281, 1.719, 0.8369},
+            {-17.95, -0.41, -0.02547, 0.0001867, 1.727, 0.7991},
+            {-18.9, -0.9289, 0.09996, -0.007049, 2.398, 0.6448},
+            {-21.44, -0.03137, -0.06307, 6.857e-05, 1.259, 1.154}};
+
+    using Features = CostModel::Coefficients;
+
+    Features features(Workload const& workload) noexcept
+    {
+        auto const log_num_rectangles = std::log1p(double(workload.num_rectangles));
+        return Features{
+                1.,
+                log_num_rectangles,
+                log_num_rectangles*log_num_rectangles,
+                workload.mean_degree,
+                std::log1p(workload.mean_degree),
+                std::log1p(double(workload.grid_bytes))};
+    }
+
+    // solves the system, matrix * solution = vector, by Gaussian elimination with partial pivoting;
+    // returns false if matrix is singular
+    template<std::size_t N>
+    bool solve_linear(std::array<std::array<double, N>, N> matrix, std::array<double, N> vector,
+                      std::array<double, N>& solution) noexcept
+    {
+        for (auto column = std::size_t{0}; column!=N; ++column) {
+            auto pivot = column;
+            for (auto row = column+1; row!=N; ++row) {
+                if (std::abs(matrix[row][column])>std::abs(matrix[pivot][column])) {
+                    pivot = row;
+                }
+            }
+            if (matrix[pivot][column]==0) {
+                return false;
+            }
+            std::swap(matrix[pivot], matrix[column]);
+            std::swap(vector[pivot], vector[column]);
+
+            for (auto row = column+1; row!=N; ++row) {
+                auto const factor = matrix[row][column]/matrix[column][column];
+                for (auto n = column; n!=N; ++n) {
+                    matrix[row][n] -= factor*matrix[column][n];
+                }
+                vector[row] -= factor*vector[column];
+            }
+        }
+
+        for (auto row = N; row--!=0;) {
+            auto sum = vector[row];
+            for (auto n = row+1; n!=N; ++n) {
+                sum -= matrix[row][n]*solution[n];
+            }
+            solution[row] = sum/matrix[row][row];
+        }
+        return true;
+    }
+
+    CostModel model;
+}
+
+namespace intersections {
+    Workload measure(Rectangles const& rectangles)
+    {
+        auto workload = Workload{};
+        workload.num_rectangles = rectangles.size();
+        workload.grid_bytes = grid_bytes(rectangles);
+        workload.cliques_bytes = cliques_bytes(rectangles);
+        if (rectangles.size()<2) {
+            return workload;
+        }
+
+        // Count the overlaps among every pair if there are few enough pairs
+        auto const num_pairs = double(rectangles.size())*double(rectangles.size()-1)/2;
+        auto num_overlaps = std::size_t{0};
+        auto num_tested = std::size_t{0};
+        if (num_pairs<=num_sampled_pairs) {
+            for (auto first = std::begin(rectangles); first!=std::end(rectangles); ++first) {
+                for (auto second = std::next(first); second!=std::end(rectangles); ++second) {
+                    num_overlaps += is_positive(*first & *second);
+                }
+            }
+            num_tested = std::size_t(num_pairs);
+        }
+        else {
+            // or else among a sample of pairs which is the same for the same rectangles.
+            std::minstd_rand gen;
+            std::uniform_int_distribution<std::size_t> distribution(0, rectangles.size()-1);
+            while (num_tested!=num_sampled_pairs) {
+                auto const first = distribution(gen);
+                auto const second = distribution(gen);
+                if (first!=second) {
+                    num_overlaps += is_positive(rectangles[first] & rectangles[second]);
+                    ++num_tested;
+                }
+            }
+        }
+        workload.mean_degree = double(num_overlaps)/double(num_tested)*double(rectangles.size()-1);
+        return workload;
+    }
+
+    char const* to_string(Solution const solution) noexcept
+    {
+        if (solution==Solution::automatic) {
+            return "automatic";
+        }
+        assert(std::size_t(solution)<num_engines);
+        return names[std::size_t(solution)];
+    }
+
+    bool from_string(char const* const name, Solution& solution) noexcept
+    {
+        for (auto n = std::size_t{0}; n!=num_engines+1; ++n) {
+            if (std::strcmp(name, to_string(Solution(n)))==0) {
+                solution = Solution(n);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    CostModel::CostModel() noexcept
+    {
+        std::copy(std::begin(default_coefficients), std::end(default_coefficients), std::begin(engines));
+    }
+
+    double CostModel::predict(Solution const solution, Workload const& workload) const noexcept
+    {
+        auto const& engine = coefficients(solution);
+        auto const x = features(workload);
+        auto log_seconds = 0.;
+        for (auto n = std::size_t{0}; n!=x.size(); ++n) {
+            log_seconds += engine[n]*x[n];
+        }
+        return std::exp(log_seconds);
+    }
+
+    Solution CostModel::choose(Workload const& workload) const noexcept
+    {
+        auto best = Solution::fast;
+        auto best_seconds = predict(best, workload);
+        for (auto n = std::size_t{0}; n!=num_engines; ++n) {
+            auto const solution = Solution(n);
+            if ((solution==Solution::grid && workload.grid_bytes>max_grid_bytes)
+                    || (solution==Solution::cliques && workload.cliques_bytes>max_cliques_bytes)) {
+                continue;
+            }
+
+            auto const seconds = predict(solution, workload);
+            if (seconds<best_seconds) {
+                best = solution;
+                best_seconds = seconds;
+            }
+        }
+        return best;
+    }
+
+    void CostModel::fit(std::vector<Sample> const& samples)
+    {
+        constexpr auto num_features = std::tuple_size<Coefficients>::value;
+        using Matrix = std::array<std::array<double, num_features>, num_features>;
+
+        for (auto n = std::size_t{0}; n!=num_engines; ++n) {
+            // Accumulate the normal equations of the samples of each solution
+            auto normal = Matrix{};
+            auto moments = Coefficients{};
+            auto num_samples = 0;
+            for (auto const& sample : samples) {
+                if (sample.solution!=Solution(n)) {
+                    continue;
+                }
+                auto const x = features(sample.workload);
+                auto const y = std::log(std::max(sample.seconds, min_seconds));
+                for (auto row = std::size_t{0}; row!=num_features; ++row) {
+                    for (auto column = std::size_t{0}; column!=num_features; ++column) {
+                        normal[row][column] += x[row]*x[column];
+                    }
+                    moments[row] += x[row]*y;
+                }
+                ++num_samples;
+            }
+            if (num_samples==0) {
+                continue;
+            }
+
+            // and solve them.
+            for (auto row = std::size_t{0}; row!=num_features; ++row) {
+                normal[row][row] += ridge*num_samples;
+            }
+            auto fitted = Coefficients{};
+            if (solve_linear(normal, moments, fitted)) {
+                engines[n] = fitted;
+            }
+        }
+    }
+
+    bool CostModel::save(char const* const filename) const
+    {
+        auto const file = std::unique_ptr<std::FILE, decltype(&std::fclose)>(std::fopen(filename, "w"), &std::fclose);
+        if (!file) {
+            return false;
+        }
+        for (auto n = std::size_t{0}; n!=num_engines; ++n) {
+            std::fprintf(file.get(), "%s", names[n]);
+            for (auto const coefficient : engines[n]) {
+                std::fprintf(file.get(), " %.17g", coefficient);
+            }
+            if (std::fprintf(file.get(), "\n")<0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool CostModel::load(char const* const filename)
+    {
+        auto const file = std::unique_ptr<std::FILE, decltype(&std::fclose)>(std::fopen(filename, "r"), &std::fclose);
+        if (!file) {
+            return false;
+        }
+
+        auto loaded = engines;
+        char name[32];
+        while (std::fscanf(file.get(), "%31s", name)==1) {
+            auto solution = Solution{};
+            if (!from_string(name, solution) || solution==Solution::automatic) {
+                return false;
+            }
+            for (auto& coefficient : loaded[std::size_t(solution)]) {
+                if (std::fscanf(file.get(), "%lf", &coefficient)!=1) {
+                    return false;
+                }
+            }
+        }
+        if (!std::feof(file.get())) {
+            return false;
+        }
+
+        engines = loaded;
+        return true;
+    }
+
+    CostModel const& cost_model() noexcept
+    {
+        return model;
+    }
+
+    void set_cost_model(CostModel const& replacement) noexcept
+    {
+        model = replacement;
+    }
+}
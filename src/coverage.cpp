@@ -0,0 +1,341 @@
+/// \file
+/// \brief defines intersections::union_area and intersections::coverage_area
+
+#include <coverage.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+using namespace intersections;
+
+namespace {
+    // an edge of a rectangle: its position in the high 32 bits, ordered as signed values,
+    // and in the low 32 bits, twice the index of the rectangle plus one if it is the end
+    using Key = std::uint64_t;
+
+    Key make_key(int const position, std::size_t const edge) noexcept
+    {
+        return (Key(std::uint32_t(position) ^ 0x80000000u) << 32) | Key(edge);
+    }
+
+    int position_of(Key const key) noexcept
+    {
+        return int(std::uint32_t(key >> 32) ^ 0x80000000u);
+    }
+
+    std::size_t edge_of(Key const key) noexcept
+    {
+        return std::size_t(key & 0xffffffffu);
+    }
+
+    // stable sort of keys by position using least-significant-digit radix sort over 16-bit digits;
+    // the edges need no order so, unlike radix_sort in transitions.h, only the position is sorted
+    void sort_by_position(std::vector<Key>& keys)
+    {
+        constexpr auto digit_bits = 16;
+        constexpr auto num_digits = 2;
+        constexpr auto radix = std::size_t{1} << digit_bits;
+        auto const size = keys.size();
+
+        std::vector<std::size_t> histograms(num_digits*radix);
+        for (auto const key : keys) {
+            for (auto digit = 0; digit!=num_digits; ++digit) {
+                ++histograms[digit*radix+((key >> (32+digit*digit_bits)) & (radix-1))];
+            }
+        }
+
+        std::vector<Key> sorted(size);
+        for (auto digit = 0; digit!=num_digits; ++digit) {
+            // digits which are the same in every key are skipped
+            auto const offsets = histograms.data()+digit*radix;
+            if (std::any_of(offsets, offsets+radix, [size](auto count) { return count==size; })) {
+                continue;
+            }
+
+            auto offset = std::size_t{0};
+            for (auto value = std::size_t{0}; value!=radix; ++value) {
+                auto const count = offsets[value];
+                offsets[value] = offset;
+                offset += count;
+            }
+
+            auto const shift = 32+digit*digit_bits;
+            for (auto const key : keys) {
+                sorted[offsets[(key >> shift) & (radix-1)]++] = key;
+            }
+            keys.swap(sorted);
+        }
+    }
+
+    // a change to the number of rectangles covering the vertical ranges in [first, last)
+    struct Change {
+        int position;
+        int delta;
+        std::uint32_t first;
+        std::uint32_t last;
+    };
+
+    // the fewest vertical ranges in a strip, as a power of two;
+    // the tree of a strip this size fits in cache
+    constexpr auto min_strip_bits = 12;
+
+    // strips are widened until the changes of the rectangles split between them
+    // number no more than this many times the changes of the whole rectangles
+    constexpr auto max_pieces_per_change = 2;
+
+    // the changes made by the rectangles, split into horizontal strips of the vertical ranges
+    struct Strips {
+        // the lengths of the ranges between the distinct vertical coordinates of the rectangles
+        std::vector<std::uint32_t> lengths;
+
+        // the number of ranges in each strip but the last, a power of two
+        std::size_t strip_size = 0;
+
+        // the changes within each strip, in horizontal order, with ranges numbered from the start of the strip;
+        // the changes of strip s are in [changes[ends[s-1]], changes[ends[s]])
+        std::vector<Change> changes;
+        std::vector<std::size_t> ends;
+    };
+
+    // returns the changes made by the rectangles in horizontal order, split into strips
+    // so that each strip can be swept through a tree small enough to stay in cache
+    Strips split_changes(Rectangles const& rectangles)
+    {
+        assert(!rectangles.empty());
+        assert(rectangles.size()<=std::numeric_limits<std::uint32_t>::max()/2);
+        auto const num_edges = rectangles.size()*2;
+        std::vector<Key> keys(num_edges);
+        Strips strips;
+
+        // Number the ranges between the vertical edges in order
+        auto const sort_edges = [&](Axis const axis) {
+            for (auto n = std::size_t{0}; n!=rectangles.size(); ++n) {
+                auto const& interval = rectangles[n].interval(axis);
+                keys[n*2] = make_key(interval.start, n*2);
+                keys[n*2+1] = make_key(interval.end, n*2+1);
+            }
+            sort_by_position(keys);
+        };
+        sort_edges(Axis::vertical);
+        std::vector<std::uint32_t> slots(num_edges);
+        auto slot = std::uint32_t{0};
+        auto previous_position = position_of(keys.front());
+        for (auto const key : keys) {
+            auto const position = position_of(key);
+            if (position!=previous_position) {
+                strips.lengths.push_back(std::uint32_t(position)-std::uint32_t(previous_position));
+                previous_position = position;
+                ++slot;
+            }
+            slots[edge_of(key)] = slot;
+        }
+
+        // and choose the narrowest strips across which the rectangles are not split too often;
+        // at worst, one strip holds every range.
+        auto const num_slots = strips.lengths.size();
+        auto const count_pieces = [&](int const strip_bits) {
+            auto num_pieces = std::size_t{0};
+            for (auto n = std::size_t{0}; n!=num_edges; n += 2) {
+                num_pieces += ((slots[n+1]-1) >> strip_bits)-(slots[n] >> strip_bits)+1;
+            }
+            return num_pieces*2;
+        };
+        auto strip_bits = min_strip_bits;
+        while ((std::size_t{1} << strip_bits)<num_slots && count_pieces(strip_bits)>num_edges*max_pieces_per_change) {
+            ++strip_bits;
+        }
+        strips.strip_size = std::size_t{1} << strip_bits;
+        auto const num_strips = (num_slots+strips.strip_size-1) >> strip_bits;
+
+        // Each strip gets a piece of each rectangle which covers part of it
+        strips.ends.assign(num_strips, 0);
+        for (auto n = std::size_t{0}; n!=num_edges; n += 2) {
+            for (auto strip = slots[n] >> strip_bits; strip<=(slots[n+1]-1) >> strip_bits; ++strip) {
+                strips.ends[strip] += 2;
+            }
+        }
+        std::partial_sum(std::begin(strips.ends), std::end(strips.ends), std::begin(strips.ends));
+
+        // and the pieces are listed in horizontal order within each strip;
+        // the starts and ends at a position may be in any order as no area lies between them.
+        sort_edges(Axis::horizontal);
+        strips.changes.resize(strips.ends.back());
+        std::vector<std::size_t> next(num_strips);
+        std::copy(std::begin(strips.ends), std::end(strips.ends)-1, std::begin(next)+1);
+        for (auto const key : keys) {
+            auto const edge = edge_of(key);
+            auto const position = position_of(key);
+            auto const delta = (edge & 1) ? -1 : 1;
+            auto const first = slots[edge & ~std::size_t{1}];
+            auto const last = slots[edge | 1];
+            for (auto strip = first >> strip_bits; strip<=(last-1) >> strip_bits; ++strip) {
+                auto const strip_first = std::uint32_t(strip << strip_bits);
+                strips.changes[next[strip]++] = Change{
+                        position, delta,
+                        std::max(first, strip_first)-strip_first,
+                        std::min(last, std::uint32_t(strip_first+strips.strip_size))-strip_first};
+            }
+        }
+        return strips;
+    }
+
+    // the length of the vertical ranges covered by at least min_depth rectangles;
+    // a segment tree over the ranges between vertical coordinates
+    // in which each node counts the rectangles which cover it but not its parent
+    // and measures how much of it is covered to each depth up to min_depth
+    class CoverageTree {
+    public:
+        // a tree with room for max_ranges ranges
+        CoverageTree(std::size_t const max_ranges, int const min_depth)
+                :min_depth(min_depth), stride(std::size_t(min_depth)+2)
+        {
+            while (num_leaves<max_ranges) {
+                num_leaves *= 2;
+            }
+            nodes.resize(num_leaves*2*stride);
+        }
+
+        // empties the tree and sets the lengths of its ranges to those in [first, last)
+        void reset(std::uint32_t const* const first, std::uint32_t const* const last) noexcept
+        {
+            assert(std::size_t(last-first)<=num_leaves);
+            std::fill(std::begin(nodes), std::end(nodes), 0);
+            for (auto leaf = std::size_t{0}; leaf!=std::size_t(last-first); ++leaf) {
+                nodes[(num_leaves+leaf)*stride+width_field] = first[leaf];
+            }
+            for (auto node = num_leaves-1; node!=0; --node) {
+                nodes[node*stride+width_field] =
+                        nodes[node*2*stride+width_field]+nodes[(node*2+1)*stride+width_field];
+            }
+        }
+
+        // add delta to the number of rectangles covering the ranges in [first, last)
+        void add(std::size_t const first, std::size_t const last, int const delta)
+        {
+            auto const first_leaf = first+num_leaves;
+            auto const last_leaf = last+num_leaves;
+            for (auto l = first_leaf, r = last_leaf; l<r; l >>= 1, r >>= 1) {
+                if (l & 1) {
+                    nodes[l*stride+count_field] += delta;
+                    update(l++);
+                }
+                if (r & 1) {
+                    nodes[--r*stride+count_field] += delta;
+                    update(r);
+                }
+            }
+
+            // the ancestors of the nodes which changed are the ancestors of the outermost leaves
+            auto l = first_leaf >> 1;
+            auto r = (last_leaf-1) >> 1;
+            for (; l!=r; l >>= 1, r >>= 1) {
+                update(l);
+                update(r);
+            }
+            for (; l!=0; l >>= 1) {
+                update(l);
+            }
+        }
+
+        // returns the length covered by at least min_depth rectangles
+        std::int64_t length() const noexcept
+        {
+            // the root is node 1
+            return nodes[stride+covered_field+min_depth-1];
+        }
+
+    private:
+        // the fields of each node
+        static constexpr std::size_t width_field = 0;
+        static constexpr std::size_t count_field = 1;
+        static constexpr std::size_t covered_field = 2;
+
+        // recalculate the length of the node covered to each depth from its count and its children
+        void update(std::size_t const node) noexcept
+        {
+            auto const fields = nodes.data()+node*stride;
+            auto const count = int(fields[count_field]);
+            auto const covered = fields+covered_field;
+            for (auto depth = 1; depth<=min_depth; ++depth) {
+                if (count>=depth) {
+                    covered[depth-1] = fields[width_field];
+                }
+                else if (node>=num_leaves) {
+                    covered[depth-1] = 0;
+                }
+                else {
+                    // the children need only be covered to the remaining depth
+                    auto const child_depth = depth-count;
+                    covered[depth-1] = nodes[node*2*stride+covered_field+child_depth-1]
+                                       +nodes[(node*2+1)*stride+covered_field+child_depth-1];
+                }
+            }
+        }
+
+        int min_depth;
+        std::size_t stride;
+        std::size_t num_leaves = 1;
+
+        // the fields of each node, stored together:
+        // the length of the ranges beneath the node,
+        // the number of rectangles which cover it but not its parent and,
+        // for each depth from 1 to min_depth, the length beneath it which is covered to at least that depth;
+        // the total length of all ranges fits in 32 bits as coordinates are ints
+        std::vector<std::uint32_t> nodes;
+    };
+
+    // returns the area covered by at least min_depth rectangles, sweeping the strips in turn
+    std::int64_t sweep(Strips const& strips, int const min_depth)
+    {
+        auto tree = CoverageTree(std::min(strips.strip_size, strips.lengths.size()), min_depth);
+        auto area = std::int64_t{0};
+        auto first_change = std::size_t{0};
+        for (auto strip = std::size_t{0}; strip!=strips.ends.size(); ++strip) {
+            auto const last_change = strips.ends[strip];
+            if (first_change==last_change) {
+                continue;
+            }
+
+            auto const first_length = strips.lengths.data()+strip*strips.strip_size;
+            auto const last_length = strips.lengths.data()+std::min((strip+1)*strips.strip_size, strips.lengths.size());
+            tree.reset(first_length, last_length);
+            auto previous_position = strips.changes[first_change].position;
+            for (auto n = first_change; n!=last_change; ++n) {
+                auto const& change = strips.changes[n];
+                if (change.position!=previous_position) {
+                    area += tree.length()*(std::int64_t(change.position)-previous_position);
+                    previous_position = change.position;
+                }
+                tree.add(change.first, change.last, change.delta);
+            }
+            first_change = last_change;
+        }
+        return area;
+    }
+}
+
+namespace intersections {
+    std::int64_t union_area(Rectangles const& rectangles)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        if (rectangles.empty()) {
+            return 0;
+        }
+
+        return sweep(split_changes(rectangles), 1);
+    }
+
+    std::int64_t coverage_area(Rectangles const& rectangles, int const min_depth)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(min_depth>0);
+        if (rectangles.empty()) {
+            return 0;
+        }
+
+        return sweep(split_changes(rectangles), min_depth);
+    }
+}
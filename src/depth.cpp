@@ -0,0 +1,208 @@
+/// \file
+/// \brief defines intersections::max_depth and supporting types
+
+#include <depth.h>
+
+#include "transitions.h"
+
+#include <algorithm>
+
+using namespace intersections;
+
+namespace {
+    // the number of rectangles covering each of the ranges between a set of vertical coordinates;
+    // a segment tree in which additions to a node are not pushed down to its children
+    class DepthTree {
+    public:
+        // coordinates must be sorted, distinct and at least two in number
+        explicit DepthTree(std::vector<int> coordinates)
+                :coordinates(std::move(coordinates)), nodes(num_slots()*4)
+        {
+            assert(this->coordinates.size()>=2);
+        }
+
+        // add delta to the depth of the ranges within interval
+        void add(Interval const& interval, int const delta)
+        {
+            add(1, 0, num_slots(), slot_of(interval.start), slot_of(interval.end), delta);
+        }
+
+        int max() const noexcept
+        {
+            return nodes[1].max;
+        }
+
+        // returns the start of a range whose depth is max()
+        int argmax() const noexcept
+        {
+            auto node = std::size_t{1};
+            auto first = std::size_t{0};
+            auto last = num_slots();
+            for (auto offset = 0; last-first>1;) {
+                offset += nodes[node].add;
+                auto const middle = (first+last)/2;
+                if (nodes[node*2].max+offset==nodes[1].max) {
+                    node = node*2;
+                    last = middle;
+                }
+                else {
+                    node = node*2+1;
+                    first = middle;
+                }
+            }
+            return coordinates[first];
+        }
+
+        // call function with the depth and length of each run of ranges with uniform depth
+        template<typename Function>
+        void for_each_uniform(Function function) const
+        {
+            for_each_uniform(1, 0, num_slots(), 0, function);
+        }
+
+    private:
+        struct Node {
+            // the extremes of the depth of the ranges beneath the node, excluding additions to its ancestors
+            int min = 0;
+            int max = 0;
+
+            // the amount added to every range beneath the node
+            int add = 0;
+        };
+
+        std::size_t num_slots() const noexcept
+        {
+            return coordinates.size()-1;
+        }
+
+        std::size_t slot_of(int const coordinate) const noexcept
+        {
+            auto const found = std::lower_bound(std::begin(coordinates), std::end(coordinates), coordinate);
+            assert(found!=std::end(coordinates) && *found==coordinate);
+            return std::size_t(found-std::begin(coordinates));
+        }
+
+        void add(
+                std::size_t const node, std::size_t const first, std::size_t const last,
+                std::size_t const add_first, std::size_t const add_last, int const delta)
+        {
+            if (add_last<=first || last<=add_first) {
+                return;
+            }
+
+            auto& n = nodes[node];
+            if (add_first<=first && last<=add_last) {
+                n.min += delta;
+                n.max += delta;
+                n.add += delta;
+                return;
+            }
+
+            auto const middle = (first+last)/2;
+            add(node*2, first, middle, add_first, add_last, delta);
+            add(node*2+1, middle, last, add_first, add_last, delta);
+            n.min = n.add+std::min(nodes[node*2].min, nodes[node*2+1].min);
+            n.max = n.add+std::max(nodes[node*2].max, nodes[node*2+1].max);
+        }
+
+        template<typename Function>
+        void for_each_uniform(
+                std::size_t const node, std::size_t const first, std::size_t const last, int const offset,
+                Function& function) const
+        {
+            auto const& n = nodes[node];
+            if (n.min==n.max) {
+                function(n.min+offset, std::int64_t(coordinates[last])-coordinates[first]);
+                return;
+            }
+
+            // only nodes whose ranges differ in depth are divided
+            auto const middle = (first+last)/2;
+            for_each_uniform(node*2, first, middle, offset+n.add, function);
+            for_each_uniform(node*2+1, middle, last, offset+n.add, function);
+        }
+
+        std::vector<int> coordinates;
+        std::vector<Node> nodes;
+    };
+
+    // helper function for intersections::max_depth; area_by_depth is optional
+    MaxDepth sweep(Rectangles const& rectangles, AreaByDepth* area_by_depth)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        if (area_by_depth) {
+            area_by_depth->clear();
+        }
+        if (rectangles.empty()) {
+            return MaxDepth{};
+        }
+
+        std::vector<int> coordinates;
+        for (auto const& rectangle : rectangles) {
+            auto const& interval = rectangle.interval(Axis::vertical);
+            coordinates.push_back(interval.start);
+            coordinates.push_back(interval.end);
+        }
+        std::sort(std::begin(coordinates), std::end(coordinates));
+        coordinates.erase(std::unique(std::begin(coordinates), std::end(coordinates)), std::end(coordinates));
+        auto tree = DepthTree(std::move(coordinates));
+
+        // Sweep horizontally through the rectangle edges
+        auto depth = 0;
+        auto x = 0;
+        auto y = 0;
+        auto const transitions = make_transitions<Axis::horizontal>(rectangles);
+        for (auto step_iterator = std::begin(transitions); step_iterator!=std::end(transitions); ++step_iterator) {
+            // updating the depth of the vertical ranges between them,
+            auto const& step = *step_iterator;
+            for (auto const ending_rectangle : step.ending) {
+                tree.add(ending_rectangle->interval(Axis::vertical), -1);
+            }
+            for (auto const starting_rectangle : step.starting) {
+                tree.add(starting_rectangle->interval(Axis::vertical), 1);
+            }
+
+            // noting the deepest point
+            if (tree.max()>depth) {
+                depth = tree.max();
+                x = step.position;
+                y = tree.argmax();
+            }
+
+            // and the area at each depth up to the next edge.
+            auto const next = std::next(step_iterator);
+            if (area_by_depth && next!=std::end(transitions)) {
+                auto const width = std::int64_t(next->position)-step.position;
+                tree.for_each_uniform([area_by_depth, width](int const range_depth, std::int64_t const length) {
+                    if (std::size_t(range_depth)>=area_by_depth->size()) {
+                        area_by_depth->resize(range_depth+1);
+                    }
+                    (*area_by_depth)[range_depth] += width*length;
+                });
+            }
+        }
+
+        // Finally, collect the rectangles which cover the deepest point.
+        auto result = MaxDepth{depth, maximum_rectangle, RectangleSequence{}};
+        for (auto const& rectangle : rectangles) {
+            if (contains(rectangle.interval(Axis::horizontal), x) && contains(rectangle.interval(Axis::vertical), y)) {
+                result.region = result.region & rectangle;
+                result.constituents.push_back(&rectangle);
+            }
+        }
+        assert(int(result.constituents.size())==depth);
+        return result;
+    }
+}
+
+namespace intersections {
+    MaxDepth max_depth(Rectangles const& rectangles)
+    {
+        return sweep(rectangles, nullptr);
+    }
+
+    MaxDepth max_depth(Rectangles const& rectangles, AreaByDepth& area_by_depth)
+    {
+        return sweep(rectangles, &area_by_depth);
+    }
+}
@@ -4,108 +4,59 @@
 
 #include <intersections.h>
 
-#include "transitions.h"
-
-#include <numeric>
-#include <set>
+#include "sweep.h"
 
 using namespace intersections;
 
-namespace {
-    // Given a set of rectangle edges aligned along an particular axis,
-    // call the given function for combinations of rectangles that span a common range.
-    template<typename Container, typename Transitions, typename Function>
-    void for_each_range(Transitions const& transitions, Function function)
-    {
-        // For each position at which rectangle edges occur,
-        Container opening_rectangles;
-        auto horizontal_end = std::end(transitions);
-        for (auto open_iterator = std::begin(transitions); open_iterator!=horizontal_end; ++open_iterator) {
-            auto const& open = open_iterator->second;
-
-            // remove rectangles with closing edges from the opening_rectangles set
-            for (auto const ending_rectangle : open.ending) {
-                opening_rectangles.erase(ending_rectangle);
-            }
-
-            // and for opening edges,
-            if (!open.starting.empty()) {
-                for (auto const starting_rectangle : open.starting) {
-                    // add them to the set
-                    opening_rectangles.insert(starting_rectangle);
-                }
-
-                // and then sweep through the remaining rectangle edges
-                // and while there there are still multiple rectangles in the set,
-                auto closing_rectangles = opening_rectangles;
-                for (auto close_iterator = std::next(open_iterator);
-                     closing_rectangles.size()>=2;
-                     ++close_iterator) {
-                    assert(close_iterator!=horizontal_end);
-
-                    // then for rectangles with closing edges,
-                    auto const& close = close_iterator->second;
-                    if (!close.ending.empty()) {
-                        // call the given function object.
-                        function(closing_rectangles);
-
-                        // Remove rectangles with closing edges from the opening_rectangles set.
-                        for (auto const ending_rectangle : close.ending) {
-                            closing_rectangles.erase(ending_rectangle);
-                        }
-                    }
-                }
-            }
-        }
-        assert(opening_rectangles.empty());
-    }
-}
-
 namespace intersections {
     template<>
-    Intersections solve<Solution::fast>(Rectangles const& rectangles)
+    void solve<Solution::fast>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
     {
         assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        Arena::Scope const scope(&arena);
+        SolveRecorder recorder(options.stats, arena);
 
-        Intersections output;
+        // reused between calls to visitor;
+        // reserved up-front because it must not grow while the sweep reclaims memory from arena
+        RectangleSequence constituents(&arena);
+        constituents.reserve(rectangles.size());
 
-        auto const horizontal_transitions = make_transitions<Axis::horizontal>(rectangles);
+        auto const horizontal_transitions = make_transitions<Axis::horizontal>(rectangles, &arena);
+        auto const no_rectangles = RectangleBitset(rectangles.data(), rectangles.size(), &arena);
 
         // For each horizontal range,
-        for_each_range<Transitions<Axis::vertical>>(
-                horizontal_transitions,
-                [&output](auto const& vertical_transitions) {
-
-                    // for each vertical sub-range,
-                    for_each_range<std::set<Rectangle const*>>(
-                            vertical_transitions,
-                            [&output](auto const& constituents) {
-
-                                // calculate the overlapping area
-                                auto overlap = std::accumulate(
-                                        std::begin(constituents), std::end(constituents),
-                                        maximum_rectangle, [](auto accumulation, auto const* rectangle) {
-                                            return accumulation & *rectangle;
-                                        });
-                                assert(is_positive(overlap));
+        auto num_results = std::size_t{0};
+        auto sweep = [&](auto const& vertical_transitions, Interval const horizontal_range) {
+            if (num_results>=options.max_results) {
+                return;
+            }
 
-                                // and look up to see if it is represented in the results.
-                                auto found = output.find(overlap);
-                                if (found!=std::end(output)) {
-                                    // If it is already represented, it should be consistent.
-                                    assert(std::equal(
-                                            std::begin(found->second), std::end(found->second),
-                                            std::begin(constituents), std::end(constituents)));
-                                }
-                                else {
-                                    // If it is not alread represented, add it.
-                                    output.emplace(
-                                            overlap,
-                                            RectangleSequence(std::begin(constituents), std::end(constituents)));
-                                }
-                            });
-                });
+            // for each overlap within it,
+            for_each_overlap(
+                    vertical_transitions, horizontal_range, no_rectangles, options,
+                    [&](Rectangle const& overlap, auto const& overlapping_rectangles) {
+                        if (num_results>=options.max_results) {
+                            return;
+                        }
 
-        return output;
+                        // report the overlap
+                        constituents.assign(std::begin(overlapping_rectangles), std::end(overlapping_rectangles));
+                        visitor(overlap, constituents);
+                        ++num_results;
+                    });
+        };
+
+        // until enough overlaps have been reported.
+        recorder.begin(&SolveStats::sweep_seconds);
+        Transitions<Axis::vertical> opening_rectangles(&arena);
+        auto const horizontal_end = std::end(horizontal_transitions);
+        for (auto open_iterator = std::begin(horizontal_transitions);
+             open_iterator!=horizontal_end && num_results<options.max_results;
+             ++open_iterator) {
+            for_each_range_from<Axis::horizontal>(
+                    open_iterator, horizontal_end, opening_rectangles, options.min_constituents, sweep);
+        }
     }
 }
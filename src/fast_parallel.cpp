@@ -0,0 +1,149 @@
+/// \file
+/// \brief defines intersections::solve<Solution::fast_parallel>
+
+#include <intersections.h>
+
+#include "parallel_for.h"
+#include "sweep.h"
+
+using namespace intersections;
+
+namespace {
+    // the results of sweeping a run of consecutive horizontal positions;
+    // allocated from the heap as they outlive the working memory of the run until they are reported
+    struct Results {
+        std::vector<Rectangle> overlaps;
+
+        // ends[n] is the end of the constituents of overlaps[n]
+        std::vector<std::size_t> ends;
+
+        RectangleSequence constituents;
+    };
+
+    // how many runs of positions to create for each thread;
+    // more runs mean finer-grained stealing but more redundant set-up
+    constexpr auto runs_per_thread = 8;
+
+    // how many swept runs may await report for each thread;
+    // bounds the memory held by results while keeping threads busy when one run is slow
+    constexpr auto pending_runs_per_thread = 2;
+}
+
+namespace intersections {
+    template<>
+    void solve<Solution::fast_parallel>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        Arena::Scope const scope(&arena);
+        SolveRecorder recorder(options.stats, arena);
+
+        auto const horizontal_transitions = make_transitions<Axis::horizontal>(rectangles, &arena);
+        auto const horizontal_begin = std::begin(horizontal_transitions);
+        auto const horizontal_end = std::end(horizontal_transitions);
+
+        // Each iteration of the outer loop of the sweep only depends on the rectangles open at its position
+        // so the positions at which rectangles open are divided into runs to be swept independently.
+        using Iterator = std::decay_t<decltype(horizontal_begin)>;
+        ArenaVector<Iterator> opening_positions(&arena);
+        for (auto open_iterator = horizontal_begin; open_iterator!=horizontal_end; ++open_iterator) {
+            if (!open_iterator->starting.empty()) {
+                opening_positions.push_back(open_iterator);
+            }
+        }
+
+        auto const num_threads = default_num_threads();
+        auto const num_positions = int(opening_positions.size());
+        auto const num_runs = std::min(num_positions, num_threads*runs_per_thread);
+
+        // stats are not thread-safe so each run counts separately
+        std::vector<SolveStats> run_stats(options.stats ? num_runs : 0);
+
+        // Runs are swept in parallel and reported in the same order as the serial sweep as soon as they finish;
+        // reporting is timed as collection while the time spent waiting for runs is timed as sweeping.
+        RectangleSequence constituents(&arena);
+        constituents.reserve(rectangles.size());
+        auto num_results = std::size_t{0};
+        auto const sweep_run = [&](int const run) {
+            auto const first = opening_positions[run*num_positions/num_runs];
+            auto const last = (run+1==num_runs)
+                              ? horizontal_end
+                              : opening_positions[(run+1)*num_positions/num_runs];
+
+            // arena is not thread-safe so each run has its own working memory
+            Arena run_arena;
+            auto const no_rectangles = RectangleBitset(rectangles.data(), rectangles.size(), &run_arena);
+            auto run_options = options;
+            run_options.stats = options.stats ? &run_stats[run] : nullptr;
+
+            // find the rectangles which are open as the sweep reaches the first position,
+            // in order of address so that their edges can be loaded in one pass
+            auto const position = first->position;
+            ArenaVector<Rectangle const*> open_rectangles(&run_arena);
+            for (auto const& rectangle : rectangles) {
+                auto const& horizontal = rectangle.interval(Axis::horizontal);
+                if (horizontal.start<position && horizontal.end>position) {
+                    open_rectangles.push_back(&rectangle);
+                }
+            }
+            Transitions<Axis::vertical> opening_rectangles(
+                    std::begin(open_rectangles), std::end(open_rectangles), &run_arena);
+
+            // and sweep the run, collecting results separately from other runs;
+            // no run needs more results than the limit as earlier runs are reported first.
+            Results run_results;
+            auto sweep = [&](auto const& vertical_transitions, Interval const horizontal_range) {
+                if (run_results.overlaps.size()>=options.max_results) {
+                    return;
+                }
+
+                for_each_overlap(
+                        vertical_transitions, horizontal_range, no_rectangles, run_options,
+                        [&](Rectangle const& overlap, auto const& overlapping_rectangles) {
+                            if (run_results.overlaps.size()>=options.max_results) {
+                                return;
+                            }
+
+                            run_results.overlaps.push_back(overlap);
+                            run_results.constituents.insert(
+                                    std::end(run_results.constituents),
+                                    std::begin(overlapping_rectangles), std::end(overlapping_rectangles));
+                            run_results.ends.push_back(run_results.constituents.size());
+                        });
+            };
+            for (auto open_iterator = first;
+                 open_iterator!=last && run_results.overlaps.size()<options.max_results;
+                 ++open_iterator) {
+                for_each_range_from<Axis::horizontal>(
+                        open_iterator, horizontal_end, opening_rectangles, options.min_constituents, sweep);
+            }
+            record(run_options.stats, &SolveStats::Counters::bytes_allocated, run_arena.allocated());
+            return run_results;
+        };
+        auto const report_run = [&](int, Results const& run_results) {
+            recorder.begin(&SolveStats::collect_seconds);
+            auto constituents_begin = std::begin(run_results.constituents);
+            for (auto n = std::size_t{0}; n!=run_results.overlaps.size(); ++n, ++num_results) {
+                if (num_results>=options.max_results) {
+                    break;
+                }
+
+                auto const constituents_end = std::begin(run_results.constituents)+run_results.ends[n];
+                constituents.assign(constituents_begin, constituents_end);
+                visitor(run_results.overlaps[n], constituents);
+                constituents_begin = constituents_end;
+            }
+            recorder.begin(&SolveStats::sweep_seconds);
+            return num_results<options.max_results;
+        };
+
+        recorder.begin(&SolveStats::sweep_seconds);
+        parallel_for_ordered(num_runs, num_threads, num_threads*pending_runs_per_thread, sweep_run, report_run);
+
+        // runs which were not swept once the limit was reached count nothing
+        for (auto const& stats : run_stats) {
+            options.stats->counts += stats.counts;
+        }
+    }
+}
@@ -0,0 +1,207 @@
+/// \file
+/// \brief defines intersections::solve<Solution::grid>
+
+#include <grid.h>
+#include <rectangle_batch.h>
+
+#include "bitset.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace intersections;
+
+namespace {
+    constexpr auto bits_per_word = RectangleBatch::rectangles_per_word;
+
+    // fills coordinates with the distinct coordinates of the edges of rectangles along axis, in ascending order
+    template<typename Coordinates>
+    void compress(Rectangles const& rectangles, Axis const axis, Coordinates& coordinates)
+    {
+        coordinates.clear();
+        coordinates.reserve(rectangles.size()*2);
+        for (auto const& rectangle : rectangles) {
+            coordinates.push_back(rectangle.interval(axis).start);
+            coordinates.push_back(rectangle.interval(axis).end);
+        }
+        std::sort(std::begin(coordinates), std::end(coordinates));
+        coordinates.erase(std::unique(std::begin(coordinates), std::end(coordinates)), std::end(coordinates));
+    }
+
+    // returns the index of coordinate in coordinates
+    template<typename Coordinates>
+    std::size_t index_of(Coordinates const& coordinates, int const coordinate) noexcept
+    {
+        auto const found = std::lower_bound(std::begin(coordinates), std::end(coordinates), coordinate);
+        assert(found!=std::end(coordinates) && *found==coordinate);
+        return std::size_t(found-std::begin(coordinates));
+    }
+
+    // returns the number of bytes in a grid of num_cells cells with a mask of num_rectangles bits;
+    // saturates rather than overflowing
+    std::size_t grid_bytes(std::size_t const num_cells, std::size_t const num_rectangles) noexcept
+    {
+        auto const bytes_per_cell = (num_rectangles+bits_per_word-1)/bits_per_word*sizeof(std::uint64_t);
+        if (bytes_per_cell!=0 && num_cells>std::numeric_limits<std::size_t>::max()/bytes_per_cell) {
+            return std::numeric_limits<std::size_t>::max();
+        }
+        return num_cells*bytes_per_cell;
+    }
+
+    // the number of rectangles in set
+    std::size_t count(std::uint64_t const* const set, std::size_t const num_words) noexcept
+    {
+        auto num_bits = std::size_t{0};
+        for (auto word = std::size_t{0}; word!=num_words; ++word) {
+            num_bits += popcount(set[word]);
+        }
+        return num_bits;
+    }
+
+    // true iff set holds a rectangle which is not in others;
+    // a missing neighbouring cell has no rectangles
+    bool has_any_not_in(
+            std::uint64_t const* const set, std::uint64_t const* const others, std::size_t const num_words) noexcept
+    {
+        if (others==nullptr) {
+            return count(set, num_words)!=0;
+        }
+        auto any = std::uint64_t{0};
+        for (auto word = std::size_t{0}; word!=num_words; ++word) {
+            any |= set[word] & ~others[word];
+        }
+        return any!=0;
+    }
+}
+
+namespace intersections {
+    std::size_t grid_bytes(Rectangles const& rectangles)
+    {
+        std::vector<int> xs, ys;
+        compress(rectangles, Axis::horizontal, xs);
+        compress(rectangles, Axis::vertical, ys);
+        if (xs.empty()) {
+            return 0;
+        }
+        return ::grid_bytes((xs.size()-1)*(ys.size()-1), rectangles.size());
+    }
+
+    template<>
+    void solve<Solution::grid>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        Arena::Scope const scope(&arena);
+        SolveRecorder recorder(options.stats, arena);
+        if (rectangles.empty()) {
+            return;
+        }
+
+        // The cells of the grid lie between consecutive distinct edge coordinates.
+        ArenaVector<int> xs(&arena), ys(&arena);
+        compress(rectangles, Axis::horizontal, xs);
+        compress(rectangles, Axis::vertical, ys);
+        auto const num_columns = xs.size()-1;
+        auto const num_rows = ys.size()-1;
+        if (::grid_bytes(num_columns*num_rows, rectangles.size())>max_grid_bytes) {
+            throw std::length_error("intersections::solve<Solution::grid>: grid exceeds max_grid_bytes");
+        }
+
+        // Mark where each rectangle begins and ends along each of its rows
+        auto const num_words = (rectangles.size()+bits_per_word-1)/bits_per_word;
+        ArenaVector<std::uint64_t> cells(num_rows*num_columns*num_words, &arena);
+        auto const cell = [&](std::size_t const row, std::size_t const column) {
+            return cells.data()+(row*num_columns+column)*num_words;
+        };
+        for (auto index = std::size_t{0}; index!=rectangles.size(); ++index) {
+            auto const& rectangle = rectangles[index];
+            auto const first_column = index_of(xs, rectangle.interval(Axis::horizontal).start);
+            auto const last_column = index_of(xs, rectangle.interval(Axis::horizontal).end);
+            auto const first_row = index_of(ys, rectangle.interval(Axis::vertical).start);
+            auto const last_row = index_of(ys, rectangle.interval(Axis::vertical).end);
+            auto const word = index/bits_per_word;
+            auto const bit = std::uint64_t{1} << (index%bits_per_word);
+            for (auto row = first_row; row!=last_row; ++row) {
+                cell(row, first_column)[word] ^= bit;
+                if (last_column!=num_columns) {
+                    cell(row, last_column)[word] ^= bit;
+                }
+            }
+        }
+
+        // and accumulate the marks along each row into the rectangles which cover each cell.
+        for (auto row = std::size_t{0}; row!=num_rows; ++row) {
+            for (auto column = std::size_t{1}; column!=num_columns; ++column) {
+                auto const previous = cell(row, column-1);
+                auto const current = cell(row, column);
+                for (auto word = std::size_t{0}; word!=num_words; ++word) {
+                    current[word] ^= previous[word];
+                }
+            }
+        }
+
+        // A rectangle covers every cell of a box of cells iff it covers the box's opposite corners.
+        // Each overlap is the box whose rectangles begin at its top-left corner and end at its bottom-right,
+        // so each is reported from exactly one pair of corners.
+        // Growing the box only removes rectangles, so the search from each top-left corner stops
+        // once too few rectangles remain or none begins at that corner.
+        recorder.begin(&SolveStats::sweep_seconds);
+        RectangleSequence constituents(&arena);
+        ArenaVector<std::uint64_t> set(num_words, &arena);
+        auto num_results = std::size_t{0};
+        for (auto row = std::size_t{0}; row!=num_rows; ++row) {
+            for (auto column = std::size_t{0}; column!=num_columns; ++column) {
+                auto const top_left = cell(row, column);
+                auto const left = (column!=0) ? cell(row, column-1) : nullptr;
+                auto const above = (row!=0) ? cell(row-1, column) : nullptr;
+
+                for (auto last_column = column; last_column!=num_columns; ++last_column) {
+                    auto last_row = row;
+                    for (; last_row!=num_rows; ++last_row) {
+                        auto const bottom_right = cell(last_row, last_column);
+                        for (auto word = std::size_t{0}; word!=num_words; ++word) {
+                            set[word] = top_left[word] & bottom_right[word];
+                        }
+                        if (count(set.data(), num_words)<options.min_constituents
+                            || !has_any_not_in(set.data(), left, num_words)
+                            || !has_any_not_in(set.data(), above, num_words)) {
+                            break;
+                        }
+
+                        auto const right = (last_column+1!=num_columns) ? cell(last_row, last_column+1) : nullptr;
+                        auto const below = (last_row+1!=num_rows) ? cell(last_row+1, last_column) : nullptr;
+                        if (!has_any_not_in(set.data(), right, num_words)
+                            || !has_any_not_in(set.data(), below, num_words)) {
+                            continue;
+                        }
+
+                        auto const overlap = Rectangle::from_intervals(
+                                Interval{xs[column], xs[last_column+1]}, Interval{ys[row], ys[last_row+1]});
+                        if (std::int64_t(overlap.w())*overlap.h()<options.min_area) {
+                            continue;
+                        }
+                        if (num_results>=options.max_results) {
+                            return;
+                        }
+
+                        constituents.clear();
+                        for (auto word = std::size_t{0}; word!=num_words; ++word) {
+                            for (auto bits = set[word]; bits!=0; bits &= bits-1) {
+                                constituents.push_back(&rectangles[word*bits_per_word+count_trailing_zeros(bits)]);
+                            }
+                        }
+                        visitor(overlap, constituents);
+                        ++num_results;
+                    }
+
+                    // A box one row high has the most rectangles of any box with this last column.
+                    if (last_row==row) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,177 @@
+/// \file
+/// \brief defines intersections::IncrementalSolver
+
+#include <incremental.h>
+
+#include "bitset.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace intersections;
+
+namespace {
+    using Id = IncrementalSolver::Id;
+
+    constexpr auto bits_per_word = RectangleBatch::rectangles_per_word;
+
+    // below this many rectangles, the simple solution is faster than the fast solution
+    constexpr auto max_simple_rectangles = std::size_t{48};
+
+    // returns the Ids of the given constituents, which point into rectangles
+    IncrementalSolver::Constituents to_ids(
+            RectangleSequence const& constituents, Rectangles const& rectangles, std::vector<Id> const& ids)
+    {
+        IncrementalSolver::Constituents constituent_ids;
+        constituent_ids.reserve(constituents.size());
+        for (auto const constituent : constituents) {
+            constituent_ids.push_back(ids[constituent-rectangles.data()]);
+        }
+        return constituent_ids;
+    }
+}
+
+namespace intersections {
+    IncrementalSolver::IncrementalSolver(Rectangles const& rectangles)
+            :rectangles(rectangles), batch(rectangles), num_rectangles(rectangles.size())
+    {
+        assert(rectangles.size()<=std::numeric_limits<Id>::max());
+        live.resize(batch.num_words(), ~std::uint64_t{0});
+        if (rectangles.size()%bits_per_word) {
+            live.back() = (std::uint64_t{1} << (rectangles.size()%bits_per_word))-1;
+        }
+
+        std::vector<Id> ids(rectangles.size());
+        std::iota(std::begin(ids), std::end(ids), Id{0});
+        auto const& owned_rectangles = this->rectangles;
+        solve<Solution::fast>(
+                owned_rectangles, [&](Rectangle const& overlap, RectangleSequence const& constituents) {
+                    overlaps.emplace(overlap, to_ids(constituents, owned_rectangles, ids));
+                }, arena);
+    }
+
+    IncrementalSolver::Id IncrementalSolver::insert(Rectangle const& rectangle, Delta& delta)
+    {
+        assert(is_positive(rectangle));
+
+        // New overlaps all lie within the rectangle
+        // and existing overlaps within it gain the rectangle as a constituent.
+        Results previous;
+        solve_window(rectangle, previous);
+
+        auto id = Id{0};
+        if (free_ids.empty()) {
+            assert(rectangles.size()<std::numeric_limits<Id>::max());
+            id = Id(rectangles.size());
+            rectangles.push_back(rectangle);
+            batch.push_back(rectangle);
+            live.resize(batch.num_words(), 0);
+        }
+        else {
+            id = free_ids.back();
+            free_ids.pop_back();
+            rectangles[id] = rectangle;
+            batch.assign(id, rectangle);
+        }
+        live[id/bits_per_word] |= std::uint64_t{1} << (id%bits_per_word);
+        ++num_rectangles;
+
+        Results updated;
+        solve_window(rectangle, updated);
+        update(previous, updated, delta);
+        return id;
+    }
+
+    void IncrementalSolver::erase(Id const id, Delta& delta)
+    {
+        assert(is_live(id));
+
+        // Only the overlaps within the rectangle have it as a constituent.
+        auto const window = rectangles[id];
+        Results previous;
+        solve_window(window, previous);
+
+        live[id/bits_per_word] &= ~(std::uint64_t{1} << (id%bits_per_word));
+        free_ids.push_back(id);
+        --num_rectangles;
+
+        Results updated;
+        solve_window(window, updated);
+        update(previous, updated, delta);
+    }
+
+    void IncrementalSolver::move(Id const id, Rectangle const& rectangle, Delta& delta)
+    {
+        assert(is_live(id));
+        assert(is_positive(rectangle));
+
+        // The overlaps which change lie within the rectangle before or after it moves.
+        auto const window = rectangles[id];
+        Results previous;
+        solve_window(window, previous);
+        solve_window(rectangle, previous);
+
+        rectangles[id] = rectangle;
+        batch.assign(id, rectangle);
+
+        Results updated;
+        solve_window(window, updated);
+        solve_window(rectangle, updated);
+        update(previous, updated, delta);
+    }
+
+    void IncrementalSolver::solve_window(Rectangle const& window, Results& window_results)
+    {
+        // Every constituent of an overlap within window overlaps window
+        // so solve only the rectangles which overlap window, in order of Id,
+        Rectangles window_rectangles;
+        std::vector<Id> ids;
+        for (auto word = std::size_t{0}; word!=batch.num_words(); ++word) {
+            for (auto mask = overlap_word(batch, word, window) & live[word]; mask!=0; mask &= mask-1) {
+                auto const id = Id(word*bits_per_word+count_trailing_zeros(mask));
+                window_rectangles.push_back(rectangles[id]);
+                ids.push_back(id);
+            }
+        }
+
+        // and keep the overlaps which lie within window.
+        auto const visitor = [&](Rectangle const& overlap, RectangleSequence const& constituents) {
+            if (contains(window, overlap)) {
+                window_results.emplace(overlap, to_ids(constituents, window_rectangles, ids));
+            }
+        };
+        if (window_rectangles.size()<=max_simple_rectangles) {
+            solve<Solution::simple>(window_rectangles, visitor, arena);
+        }
+        else {
+            solve<Solution::fast>(window_rectangles, visitor, arena);
+        }
+    }
+
+    void IncrementalSolver::update(Results const& previous, Results const& updated, Delta& delta)
+    {
+        auto const is_in = [](Results const& results, Result const& result) {
+            auto const found = results.find(result.first);
+            return found!=std::end(results) && found->second==result.second;
+        };
+
+        for (auto const& result : previous) {
+            if (!is_in(updated, result)) {
+                if (!overlaps.erase(result.first)) {
+                    assert(false);
+                }
+                delta.removed.push_back(result);
+            }
+        }
+
+        for (auto const& result : updated) {
+            if (!is_in(previous, result)) {
+                if (!overlaps.emplace(result.first, result.second).second) {
+                    assert(false);
+                }
+                delta.added.push_back(result);
+            }
+        }
+    }
+}
@@ -3,17 +3,28 @@
 //
 
 /// \file
-/// \brief command-line tool reads JSON file and prints intersections
+/// \brief command-line tool reads JSON or binary rectangle file and prints intersections
 
-#include <intersections.h>
+#include <compact_intersections.h>
+#include <cost_model.h>
+#include <rectangle_file.h>
 
+#include "rectangles_handler.h"
+
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 #include "rapidjson_assert.h"
-#include <rapidjson/document.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/reader.h>
 
 namespace {
-    auto load_file(char const* const filename)
+    // the size of the chunks in which JSON files are read
+    constexpr auto json_chunk_size = std::size_t{64*1024};
+
+    // parses rectangles from a JSON file as it is read so that only one chunk of the file is held at once
+    auto load_json_rectangles(char const* const filename)
     {
         auto const file = std::fopen(filename, "rb");
         if (file==nullptr) {
@@ -21,46 +32,38 @@ namespace {
             std::exit(EXIT_FAILURE);
         }
 
-        std::fseek(file, 0, SEEK_END);
-        auto ftell_result = std::ftell(file);
-        if (ftell_result<0) {
-            std::fprintf(stderr, "error determining size of JSON file, \"%s\"", filename);
-            std::exit(EXIT_FAILURE);
-        }
-        auto file_size = static_cast<std::size_t>(ftell_result);
+        auto const buffer = std::unique_ptr<char[]>(new char[json_chunk_size]);
+        rapidjson::FileReadStream stream(file, buffer.get(), json_chunk_size);
 
-        auto buffer = std::unique_ptr<char[]>(new char[file_size+1]);
-        if (!buffer) {
-            std::fprintf(stderr, "error accomodating JSON file, \"%s\"", filename);
+        auto rectangles = intersections::Rectangles{};
+        intersections::RectanglesHandler handler(rectangles);
+        rapidjson::Reader reader;
+        auto const result = reader.Parse(stream, handler);
+        std::fclose(file);
+        if (result.IsError()) {
+            std::fprintf(stderr, "parse error at position %zd of JSON file, \"%s\"", result.Offset(), filename);
             std::exit(EXIT_FAILURE);
         }
-
-        std::fseek(file, 0, SEEK_SET);
-        auto read = std::fread(buffer.get(), file_size, 1, file);
-        if (read!=1) {
-            std::fprintf(stderr, "error reading JSON file, \"%s\"", filename);
-            std::exit(EXIT_FAILURE);
+        if (!handler.has_rects()) {
+            on_dom_error();
         }
-        buffer[file_size] = '\0';
 
-        return buffer;
+        return rectangles;
     }
 
-    auto read_rectangles(rapidjson::Document const& document)
+    // reads rectangles from a binary rectangle file, mapped rather than parsed, or a JSON file
+    auto load_rectangles(char const* const filename)
     {
-        auto rectangles = intersections::Rectangles{};
-        auto const& json_rects = document["rects"].GetArray();
-        std::transform(std::begin(json_rects), std::end(json_rects), std::back_inserter(rectangles),
-                [](auto const& json_rect) {
-                    return intersections::Rectangle {
-                            json_rect["x"].GetInt(),
-                            json_rect["y"].GetInt(),
-                            json_rect["w"].GetInt(),
-                            json_rect["h"].GetInt()
-                    };
-                }
-        );
-        return rectangles;
+        if (!intersections::is_rectangle_file(filename)) {
+            return load_json_rectangles(filename);
+        }
+
+        intersections::RectangleFile file;
+        if (!file.open(filename)) {
+            std::fprintf(stderr, "error mapping rectangle file, \"%s\"", filename);
+            std::exit(EXIT_FAILURE);
+        }
+        return file.rectangles();
     }
 
     auto print_input(intersections::Rectangles const& rectangles) noexcept
@@ -75,27 +78,26 @@ namespace {
         }
     }
 
-    auto print_solution(intersections::Intersections const& intersections,
-            intersections::Rectangle const* rectangles_begin) noexcept
+    auto print_solution(intersections::CompactIntersections const& intersections) noexcept
     {
         std::puts("Intersections:");
-        for (auto const& intersection : intersections) {
-            auto const& intersectees = intersection.second;
+        for (auto n = std::size_t{0}; n!=intersections.size(); ++n) {
+            auto const intersectees = intersections.constituents(n);
             std::printf("\tBetween rectangle ");
-            auto print_index = [&](auto const rectangle) {
-                std::printf("%d", int(std::distance(rectangles_begin, rectangle)+1));
+            auto print_index = [&](auto const index) {
+                std::printf("%d", int(index+1));
             };
-            assert (!intersectees.empty());
+            assert (intersectees.size()>=2);
             auto second_from_back = std::prev(std::end(intersectees), 2);
-            std::for_each(std::begin(intersectees), second_from_back, [&](auto const rectangle) {
-                print_index(rectangle);
+            std::for_each(std::begin(intersectees), second_from_back, [&](auto const index) {
+                print_index(index);
                 std::printf(", ");
             });
             print_index(*second_from_back);
             std::printf(" and ");
             print_index(*std::prev(std::end(intersectees), 1));
 
-            auto const& overlap = intersection.first;
+            auto const& overlap = intersections.overlap(n);
             std::printf(" at (%d, %d), w=%d, h=%d\n", overlap.x(), overlap.y(), overlap.w(), overlap.h());
         }
     }
@@ -103,34 +105,43 @@ namespace {
 
 int main(int argc, char** argv)
 {
-    // load file into buffer
+    // load the cost model from a calibration file if one is given
+    if (auto const model_filename = std::getenv("INTERSECTIONS_COST_MODEL")) {
+        auto model = intersections::CostModel{};
+        if (!model.load(model_filename)) {
+            std::fprintf(stderr, "error loading cost model file, \"%s\"", model_filename);
+            return EXIT_FAILURE;
+        }
+        intersections::set_cost_model(model);
+    }
+
+    // convert a JSON file to a binary rectangle file
+    if (argc==4 && std::strcmp(argv[1], "--convert")==0) {
+        auto const rectangles = load_json_rectangles(argv[2]);
+        if (!intersections::save_rectangle_file(argv[3], rectangles)) {
+            std::fprintf(stderr, "error saving rectangle file, \"%s\"", argv[3]);
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // or load rectangles from file
     if (argc!=2) {
         std::puts("Please provide a rectangles file.");
         return EXIT_FAILURE;
     }
-    auto const filename = argv[1];
-    auto const buffer = load_file(filename);
-
-    // parse buffer into document
-    rapidjson::Document document;
-    if (document.ParseInsitu(buffer.get()).HasParseError()) {
-        std::fprintf(stderr, "parse error at position %zd of JSON file, \"%s\"", document.GetErrorOffset(),
-                filename);
-        return EXIT_FAILURE;
-    }
-
-    // read rectangles from document
-    auto rectangles = read_rectangles(document);
+    auto const rectangles = load_rectangles(argv[1]);
 
     // print the input list
     print_input(rectangles);
     std::putchar('\n');
 
     // solve
-    auto intersections = intersections::solve<intersections::Solution::fast>(rectangles);
+    auto intersections = intersections::CompactIntersections{};
+    intersections::solve<intersections::Solution::automatic>(rectangles, intersections);
 
     // print the solutions
-    print_solution(intersections, rectangles.data());
+    print_solution(intersections);
 
     return EXIT_SUCCESS;
 }
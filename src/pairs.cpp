@@ -0,0 +1,232 @@
+/// \file
+/// \brief defines intersections::overlapping_pairs and supporting types
+
+#include <overlap_graph.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+using namespace intersections;
+
+namespace {
+    using Index = OverlapGraph::Index;
+
+    // marks the end of a list
+    constexpr auto no_entry = std::numeric_limits<Index>::max();
+
+    // the rectangles which are open in a horizontal sweep, indexed by their vertical intervals
+    // using a segment tree over the vertical coordinates of all of the rectangles;
+    // rectangles which have closed are removed lazily when they are next encountered
+    // so that each query runs in O(log n) time plus the number of rectangles visited
+    class ActiveSet {
+    public:
+        explicit ActiveSet(Rectangles const& rectangles)
+                :rectangles(rectangles)
+        {
+            for (auto const& rectangle : rectangles) {
+                auto const& interval = rectangle.interval(Axis::vertical);
+                coordinates.push_back(interval.start);
+                coordinates.push_back(interval.end);
+            }
+            std::sort(std::begin(coordinates), std::end(coordinates));
+            coordinates.erase(std::unique(std::begin(coordinates), std::end(coordinates)), std::end(coordinates));
+
+            // leaves represent the ranges between adjacent coordinates
+            while (num_leaves+1<coordinates.size()) {
+                num_leaves *= 2;
+            }
+            covering.resize(num_leaves*2, no_entry);
+            starting.resize(num_leaves*2, no_entry);
+            num_starting.resize(num_leaves*2, 0);
+        }
+
+        void insert(Index const rectangle)
+        {
+            auto const& interval = rectangles[rectangle].interval(Axis::vertical);
+            auto const first = leaf_of(interval.start);
+            auto const last = leaf_of(interval.end);
+
+            // add the rectangle to the nodes which cover its interval
+            for (auto l = first, r = last; l<r; l >>= 1, r >>= 1) {
+                if (l & 1) {
+                    push_front(covering[l++], rectangle);
+                }
+                if (r & 1) {
+                    push_front(covering[--r], rectangle);
+                }
+            }
+
+            // and to the leaf at which it starts
+            push_front(starting[first], rectangle);
+            for (auto node = first; node!=0; node >>= 1) {
+                ++num_starting[node];
+            }
+        }
+
+        // call function for each rectangle in the set which overlaps the given rectangle vertically;
+        // rectangles which end at or before position horizontally are removed
+        template<typename Function>
+        void for_each_overlapping(Index const rectangle, int const position, Function function)
+        {
+            auto const& interval = rectangles[rectangle].interval(Axis::vertical);
+            auto const first = leaf_of(interval.start);
+            auto const last = leaf_of(interval.end);
+
+            // report rectangles which start above the interval and extend into it
+            for (auto node = first; node!=0; node >>= 1) {
+                for_each_entry(covering[node], position, [&](Index const active) {
+                    if (rectangles[active].interval(Axis::vertical).start<interval.start) {
+                        function(active);
+                    }
+                });
+            }
+
+            // and rectangles which start within the interval
+            for (auto l = first, r = last; l<r; l >>= 1, r >>= 1) {
+                if (l & 1) {
+                    for_each_starting(l++, position, function);
+                }
+                if (r & 1) {
+                    for_each_starting(--r, position, function);
+                }
+            }
+        }
+
+    private:
+        // node of a singly-linked list of rectangles
+        struct Entry {
+            Index rectangle;
+            Index next;
+        };
+
+        std::size_t leaf_of(int const coordinate) const noexcept
+        {
+            auto const found = std::lower_bound(std::begin(coordinates), std::end(coordinates), coordinate);
+            assert(found!=std::end(coordinates) && *found==coordinate);
+            return num_leaves+std::size_t(found-std::begin(coordinates));
+        }
+
+        void push_front(Index& head, Index const rectangle)
+        {
+            assert(entries.size()<no_entry);
+            entries.push_back(Entry{rectangle, head});
+            head = Index(entries.size()-1);
+        }
+
+        // call function for each rectangle in the list which is still open at position;
+        // returns the number of closed rectangles which were removed from the list
+        template<typename Function>
+        int for_each_entry(Index& head, int const position, Function&& function)
+        {
+            auto num_removed = 0;
+            for (auto link = &head; *link!=no_entry;) {
+                auto& entry = entries[*link];
+                if (rectangles[entry.rectangle].interval(Axis::horizontal).end<=position) {
+                    *link = entry.next;
+                    ++num_removed;
+                    continue;
+                }
+
+                function(entry.rectangle);
+                link = &entry.next;
+            }
+            return num_removed;
+        }
+
+        // call function for each open rectangle which starts within the given node
+        template<typename Function>
+        void for_each_starting(std::size_t const node, int const position, Function& function)
+        {
+            if (num_starting[node]==0) {
+                return;
+            }
+
+            if (node<num_leaves) {
+                for_each_starting(node*2, position, function);
+                for_each_starting(node*2+1, position, function);
+                return;
+            }
+
+            auto const num_removed = for_each_entry(starting[node], position, function);
+            for (auto ancestor = node; ancestor!=0; ancestor >>= 1) {
+                num_starting[ancestor] -= num_removed;
+            }
+        }
+
+        Rectangles const& rectangles;
+
+        // the sorted, distinct vertical coordinates of the rectangles
+        std::vector<int> coordinates;
+        std::size_t num_leaves = 1;
+
+        // storage for the lists of each node
+        std::vector<Entry> entries;
+
+        // for each node, the rectangles which span it but not its parent
+        std::vector<Index> covering;
+
+        // for each leaf, the rectangles which start there
+        std::vector<Index> starting;
+
+        // for each node, the number of rectangles in starting at leaves beneath it
+        std::vector<int> num_starting;
+    };
+
+    // distribute edges into a graph in which the neighbors of each vertex are sorted
+    OverlapGraph make_graph(std::size_t const num_vertices, std::vector<std::pair<Index, Index>> const& edges)
+    {
+        std::vector<std::size_t> offsets(num_vertices+1, 0);
+        for (auto const& edge : edges) {
+            ++offsets[edge.first+1];
+            ++offsets[edge.second+1];
+        }
+        std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+
+        // the edges in both directions, ordered by neighbor
+        std::vector<std::pair<Index, Index>> by_neighbor(offsets.back());
+        auto next = offsets;
+        for (auto const& edge : edges) {
+            by_neighbor[next[edge.second]++] = edge;
+            by_neighbor[next[edge.first]++] = std::make_pair(edge.second, edge.first);
+        }
+
+        // are stably distributed to their vertices
+        std::vector<Index> indices(offsets.back());
+        next = offsets;
+        for (auto const& edge : by_neighbor) {
+            indices[next[edge.first]++] = edge.second;
+        }
+
+        return OverlapGraph(std::move(offsets), std::move(indices));
+    }
+}
+
+namespace intersections {
+    OverlapGraph overlapping_pairs(Rectangles const& rectangles)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(rectangles.size()<std::numeric_limits<Index>::max());
+
+        // sweep horizontally through the rectangles in order of their starting edge
+        std::vector<Index> order(rectangles.size());
+        std::iota(std::begin(order), std::end(order), Index{0});
+        std::stable_sort(std::begin(order), std::end(order), [&rectangles](Index const lhs, Index const rhs) {
+            return rectangles[lhs].interval(Axis::horizontal).start<rectangles[rhs].interval(Axis::horizontal).start;
+        });
+
+        // and pair each rectangle with the open rectangles which overlap it vertically.
+        std::vector<std::pair<Index, Index>> edges;
+        ActiveSet active_set(rectangles);
+        for (auto const rectangle : order) {
+            auto const position = rectangles[rectangle].interval(Axis::horizontal).start;
+            active_set.for_each_overlapping(rectangle, position, [&edges, rectangle](Index const active) {
+                edges.emplace_back(std::min(active, rectangle), std::max(active, rectangle));
+            });
+            active_set.insert(rectangle);
+        }
+
+        return make_graph(rectangles.size(), edges);
+    }
+}
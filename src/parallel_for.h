@@ -0,0 +1,222 @@
+/// \file
+/// \brief definition of intersections::parallel_for and intersections::parallel_for_ordered
+
+#ifndef INTERSECTIONS_PARALLEL_FOR_H
+#define INTERSECTIONS_PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace intersections {
+    // returns the number of threads with which to perform parallel work
+    inline int default_num_threads() noexcept
+    {
+        return std::max(1, int(std::thread::hardware_concurrency()));
+    }
+
+    // call task(n) for each n in [0, num_tasks) using num_threads threads;
+    // each thread is dealt a contiguous block of tasks and works through it from the front;
+    // when its block is exhausted, it steals tasks from the back of other threads' blocks;
+    // if a task throws, no more tasks are started and the first exception is rethrown once all threads are joined
+    template<typename Task>
+    void parallel_for(int const num_tasks, int const num_threads, Task task)
+    {
+        assert(num_threads>0);
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<int> tasks;
+        };
+        std::vector<Queue> queues(num_threads);
+        for (auto n = 0; n!=num_tasks; ++n) {
+            queues[n*num_threads/num_tasks].tasks.push_back(n);
+        }
+
+        // returns next task or -1 if the queue is empty
+        auto pop = [](Queue& queue, bool owner) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                return -1;
+            }
+
+            auto n = 0;
+            if (owner) {
+                n = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            else {
+                n = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            return n;
+        };
+
+        // an exception must not escape a thread so the first is kept to be rethrown by the calling thread
+        std::mutex exception_mutex;
+        std::exception_ptr exception;
+        std::atomic<bool> is_failed{false};
+
+        auto work = [&](int const thread) {
+            try {
+                while (!is_failed) {
+                    auto n = pop(queues[thread], true);
+                    for (auto victim = 1; n<0 && victim!=num_threads; ++victim) {
+                        n = pop(queues[(thread+victim)%num_threads], false);
+                    }
+
+                    // tasks do not create tasks so once all queues are empty, work is done
+                    if (n<0) {
+                        return;
+                    }
+
+                    task(n);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+                is_failed = true;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto thread = 1; thread<num_threads; ++thread) {
+            threads.emplace_back(work, thread);
+        }
+        work(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // call task(n) for each n in [0, num_tasks) using num_threads threads
+    // and, on the calling thread, report(n, result) with the result of each in order of n;
+    // tasks are started in order and no task is started until fewer than max_pending results await report,
+    // so no more than max_pending results are held at once;
+    // if report returns false, no more tasks are started or reported;
+    // if a task or report throws, no more tasks are started and the first exception is rethrown once all threads are joined
+    template<typename Task, typename Report>
+    void parallel_for_ordered(int const num_tasks, int const num_threads, int const max_pending, Task task, Report report)
+    {
+        assert(num_threads>0);
+        assert(max_pending>0);
+
+        // the result of task n is held in results[n%max_pending] until it is reported
+        using Result = decltype(task(0));
+        std::vector<Result> results(max_pending);
+        std::vector<bool> is_ready(max_pending, false);
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        auto next_task = 0;
+        auto num_reported = 0;
+        auto is_stopped = false;
+        std::exception_ptr exception;
+
+        // an exception must not escape a thread so the first is kept to be rethrown by the calling thread
+        auto const fail = [&](std::exception_ptr const& task_exception) {
+            if (!exception) {
+                exception = task_exception;
+            }
+            is_stopped = true;
+        };
+
+        auto work = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                condition.wait(lock, [&]() {
+                    return is_stopped || next_task==num_tasks || next_task-num_reported<max_pending;
+                });
+                if (is_stopped || next_task==num_tasks) {
+                    return;
+                }
+
+                auto const n = next_task++;
+                lock.unlock();
+                auto result = Result{};
+                auto task_exception = std::exception_ptr{};
+                try {
+                    result = task(n);
+                }
+                catch (...) {
+                    task_exception = std::current_exception();
+                }
+                lock.lock();
+
+                if (task_exception) {
+                    fail(task_exception);
+                }
+                else {
+                    results[n%max_pending] = std::move(result);
+                    is_ready[n%max_pending] = true;
+                }
+                condition.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto thread = 0; thread!=num_threads; ++thread) {
+            threads.emplace_back(work);
+        }
+
+        // a result is only replaced once it has been reported so it can be reported without the lock
+        for (auto n = 0; n!=num_tasks; ++n) {
+            auto const slot = n%max_pending;
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return is_stopped || is_ready[slot]; });
+            if (is_stopped) {
+                break;
+            }
+            lock.unlock();
+
+            auto is_continued = true;
+            auto report_exception = std::exception_ptr{};
+            try {
+                is_continued = report(n, results[slot]);
+            }
+            catch (...) {
+                report_exception = std::current_exception();
+            }
+            lock.lock();
+
+            results[slot] = Result{};
+            is_ready[slot] = false;
+            ++num_reported;
+            if (report_exception) {
+                fail(report_exception);
+            }
+            else if (!is_continued) {
+                is_stopped = true;
+            }
+            condition.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_stopped = true;
+        }
+        condition.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
+#endif //INTERSECTIONS_PARALLEL_FOR_H
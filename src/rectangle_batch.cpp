@@ -0,0 +1,169 @@
+/// \file
+/// \brief defines the kernels which operate on intersections::RectangleBatch
+
+#include <rectangle_batch.h>
+
+// SIMD kernels are compiled for specific targets and chosen at run-time
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define INTERSECTIONS_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+using namespace intersections;
+
+namespace {
+    using OverlapWordKernel = std::uint64_t (*)(RectangleBatch const&, std::size_t, Rectangle const&);
+
+    std::uint64_t overlap_word_scalar(
+            RectangleBatch const& batch, std::size_t const word, Rectangle const& rectangle) noexcept
+    {
+        auto const first = word*RectangleBatch::rectangles_per_word;
+        auto const x0 = batch.x0()+first;
+        auto const x1 = batch.x1()+first;
+        auto const y0 = batch.y0()+first;
+        auto const y1 = batch.y1()+first;
+        auto const& horizontal = rectangle.interval(Axis::horizontal);
+        auto const& vertical = rectangle.interval(Axis::vertical);
+
+        auto mask = std::uint64_t{0};
+        for (auto n = std::size_t{0}; n!=RectangleBatch::rectangles_per_word; ++n) {
+            auto const overlaps = (x0[n]<horizontal.end) & (horizontal.start<x1[n])
+                                  & (y0[n]<vertical.end) & (vertical.start<y1[n]);
+            mask |= std::uint64_t(overlaps) << n;
+        }
+        return mask;
+    }
+
+#if defined(INTERSECTIONS_X86_DISPATCH)
+    __attribute__((target("sse2")))
+    std::uint64_t overlap_word_sse2(
+            RectangleBatch const& batch, std::size_t const word, Rectangle const& rectangle) noexcept
+    {
+        auto const first = word*RectangleBatch::rectangles_per_word;
+        auto const x0 = reinterpret_cast<__m128i const*>(batch.x0()+first);
+        auto const x1 = reinterpret_cast<__m128i const*>(batch.x1()+first);
+        auto const y0 = reinterpret_cast<__m128i const*>(batch.y0()+first);
+        auto const y1 = reinterpret_cast<__m128i const*>(batch.y1()+first);
+        auto const start_x = _mm_set1_epi32(rectangle.interval(Axis::horizontal).start);
+        auto const end_x = _mm_set1_epi32(rectangle.interval(Axis::horizontal).end);
+        auto const start_y = _mm_set1_epi32(rectangle.interval(Axis::vertical).start);
+        auto const end_y = _mm_set1_epi32(rectangle.interval(Axis::vertical).end);
+
+        constexpr auto lanes = 4;
+        auto mask = std::uint64_t{0};
+        for (auto n = 0; n!=int(RectangleBatch::rectangles_per_word)/lanes; ++n) {
+            auto const overlaps = _mm_and_si128(
+                    _mm_and_si128(_mm_cmpgt_epi32(end_x, _mm_load_si128(x0+n)),
+                                  _mm_cmpgt_epi32(_mm_load_si128(x1+n), start_x)),
+                    _mm_and_si128(_mm_cmpgt_epi32(end_y, _mm_load_si128(y0+n)),
+                                  _mm_cmpgt_epi32(_mm_load_si128(y1+n), start_y)));
+            mask |= std::uint64_t(_mm_movemask_ps(_mm_castsi128_ps(overlaps))) << (n*lanes);
+        }
+        return mask;
+    }
+
+    __attribute__((target("avx2")))
+    std::uint64_t overlap_word_avx2(
+            RectangleBatch const& batch, std::size_t const word, Rectangle const& rectangle) noexcept
+    {
+        auto const first = word*RectangleBatch::rectangles_per_word;
+        auto const x0 = reinterpret_cast<__m256i const*>(batch.x0()+first);
+        auto const x1 = reinterpret_cast<__m256i const*>(batch.x1()+first);
+        auto const y0 = reinterpret_cast<__m256i const*>(batch.y0()+first);
+        auto const y1 = reinterpret_cast<__m256i const*>(batch.y1()+first);
+        auto const start_x = _mm256_set1_epi32(rectangle.interval(Axis::horizontal).start);
+        auto const end_x = _mm256_set1_epi32(rectangle.interval(Axis::horizontal).end);
+        auto const start_y = _mm256_set1_epi32(rectangle.interval(Axis::vertical).start);
+        auto const end_y = _mm256_set1_epi32(rectangle.interval(Axis::vertical).end);
+
+        constexpr auto lanes = 8;
+        auto mask = std::uint64_t{0};
+        for (auto n = 0; n!=int(RectangleBatch::rectangles_per_word)/lanes; ++n) {
+            auto const overlaps = _mm256_and_si256(
+                    _mm256_and_si256(_mm256_cmpgt_epi32(end_x, _mm256_load_si256(x0+n)),
+                                     _mm256_cmpgt_epi32(_mm256_load_si256(x1+n), start_x)),
+                    _mm256_and_si256(_mm256_cmpgt_epi32(end_y, _mm256_load_si256(y0+n)),
+                                     _mm256_cmpgt_epi32(_mm256_load_si256(y1+n), start_y)));
+            mask |= std::uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(overlaps))) << (n*lanes);
+        }
+        return mask;
+    }
+#endif
+
+    OverlapWordKernel overlap_word_kernel(Isa const isa) noexcept
+    {
+        assert(is_supported(isa));
+        switch (isa) {
+#if defined(INTERSECTIONS_X86_DISPATCH)
+        case Isa::avx2:
+            return overlap_word_avx2;
+        case Isa::sse2:
+            return overlap_word_sse2;
+#endif
+        default:
+            return overlap_word_scalar;
+        }
+    }
+}
+
+namespace intersections {
+    bool is_supported(Isa const isa) noexcept
+    {
+        switch (isa) {
+        case Isa::scalar:
+            return true;
+#if defined(INTERSECTIONS_X86_DISPATCH)
+        case Isa::sse2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case Isa::avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Isa best_isa() noexcept
+    {
+        static auto const best = is_supported(Isa::avx2)
+                                 ? Isa::avx2
+                                 : is_supported(Isa::sse2) ? Isa::sse2 : Isa::scalar;
+        return best;
+    }
+
+    std::uint64_t overlap_word(RectangleBatch const& batch, std::size_t word, Rectangle const& rectangle) noexcept
+    {
+        static auto const kernel = overlap_word_kernel(best_isa());
+        assert(word<batch.num_words());
+        return kernel(batch, word, rectangle);
+    }
+
+    std::uint64_t overlap_word(
+            RectangleBatch const& batch, std::size_t word, Rectangle const& rectangle, Isa isa) noexcept
+    {
+        assert(word<batch.num_words());
+        return overlap_word_kernel(isa)(batch, word, rectangle);
+    }
+
+    std::vector<std::uint64_t> overlap_matrix(RectangleBatch const& batch, Isa isa)
+    {
+        auto const kernel = overlap_word_kernel(isa);
+        auto const num_words = batch.num_words();
+
+        std::vector<std::uint64_t> rows(batch.size()*num_words);
+        for (auto n = std::size_t{0}; n!=batch.size(); ++n) {
+            auto const row = rows.data()+n*num_words;
+            auto const rectangle = batch[n];
+            for (auto word = std::size_t{0}; word!=num_words; ++word) {
+                row[word] = kernel(batch, word, rectangle);
+            }
+
+            // a rectangle does not overlap itself
+            row[n/RectangleBatch::rectangles_per_word] &=
+                    ~(std::uint64_t{1} << (n%RectangleBatch::rectangles_per_word));
+        }
+        return rows;
+    }
+}
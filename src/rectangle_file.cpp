@@ -0,0 +1,253 @@
+/// \file
+/// \brief defines intersections::RectangleFile and related functions
+
+#include <rectangle_file.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace intersections;
+
+namespace {
+    constexpr char magic[4] = {'R', 'E', 'C', 'T'};
+    constexpr std::uint32_t version = 1;
+
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t num_rectangles;
+        std::uint32_t coordinate_width;
+        std::uint32_t reserved;
+    };
+    static_assert(sizeof(Header)==RectangleFile::header_size, "unexpected padding in Header");
+
+    // the format is little-endian so the header and arrays are used in place on little-endian hosts only
+    bool is_little_endian() noexcept
+    {
+        auto const one = std::uint32_t{1};
+        char first_byte;
+        std::memcpy(&first_byte, &one, 1);
+        return first_byte==1;
+    }
+
+    // returns true iff header is valid and describes a file of file_size bytes
+    bool is_valid(Header const& header, std::size_t const file_size) noexcept
+    {
+        if (std::memcmp(header.magic, magic, sizeof(magic))!=0 || header.version!=version
+                || (header.coordinate_width!=2 && header.coordinate_width!=4)) {
+            return false;
+        }
+
+        auto const max_rectangles = (file_size-RectangleFile::header_size)/(4*header.coordinate_width);
+        return header.num_rectangles<=max_rectangles
+               && file_size==RectangleFile::header_size+header.num_rectangles*4*header.coordinate_width;
+    }
+
+    // returns true iff every rectangle in the arrays beginning at xs has a positive width and height
+    // and ends at a coordinate which fits in an int
+    template<typename Coordinate>
+    bool are_valid_arrays(Coordinate const* const xs, std::size_t const size) noexcept
+    {
+        auto const ys = xs+size;
+        auto const ws = ys+size;
+        auto const hs = ws+size;
+
+        constexpr auto max_coordinate = std::int64_t{std::numeric_limits<int>::max()};
+        for (auto n = std::size_t{0}; n!=size; ++n) {
+            if (ws[n]<=0 || hs[n]<=0
+                    || std::int64_t{xs[n]}+ws[n]>max_coordinate || std::int64_t{ys[n]}+hs[n]>max_coordinate) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Coordinate>
+    Rectangles read_arrays(Coordinate const* const xs, std::size_t const size)
+    {
+        auto const ys = xs+size;
+        auto const ws = ys+size;
+        auto const hs = ws+size;
+
+        Rectangles rectangles;
+        rectangles.reserve(size);
+        for (auto n = std::size_t{0}; n!=size; ++n) {
+            rectangles.emplace_back(xs[n], ys[n], ws[n], hs[n]);
+        }
+        return rectangles;
+    }
+
+    template<typename Coordinate>
+    bool write_arrays(std::FILE* const file, Rectangles const& rectangles)
+    {
+        // one array at a time, in blocks so that the conversion does not need a copy of every rectangle
+        constexpr auto block_size = std::size_t{4096};
+        Coordinate block[block_size];
+        for (auto array = 0; array!=4; ++array) {
+            for (auto first = std::size_t{0}; first<rectangles.size(); first += block_size) {
+                auto const last = std::min(first+block_size, rectangles.size());
+                for (auto n = first; n!=last; ++n) {
+                    auto const& rectangle = rectangles[n];
+                    int const coordinates[] = {rectangle.x(), rectangle.y(), rectangle.w(), rectangle.h()};
+                    block[n-first] = Coordinate(coordinates[array]);
+                }
+                if (std::fwrite(block, sizeof(Coordinate), last-first, file)!=last-first) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+namespace intersections {
+    RectangleFile::~RectangleFile()
+    {
+        close();
+    }
+
+    bool RectangleFile::open(char const* const filename)
+    {
+        close();
+        if (!is_little_endian()) {
+            return false;
+        }
+
+#if defined(__unix__) || defined(__APPLE__)
+        // Map the file,
+        auto const descriptor = ::open(filename, O_RDONLY);
+        if (descriptor<0) {
+            return false;
+        }
+        struct stat status{};
+        if (::fstat(descriptor, &status)!=0 || std::size_t(status.st_size)<header_size) {
+            ::close(descriptor);
+            return false;
+        }
+        auto const file_size = std::size_t(status.st_size);
+        auto const address = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        if (address==MAP_FAILED) {
+            return false;
+        }
+        mapping = address;
+        mapping_size = file_size;
+#else
+        // or where memory mapping is not available, read it.
+        auto const file = std::fopen(filename, "rb");
+        if (file==nullptr) {
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        auto const ftell_result = std::ftell(file);
+        if (ftell_result<long(header_size)) {
+            std::fclose(file);
+            return false;
+        }
+        auto const file_size = std::size_t(ftell_result);
+        auto buffer = std::unique_ptr<std::uint64_t[]>(new std::uint64_t[(file_size+7)/8]);
+        std::fseek(file, 0, SEEK_SET);
+        auto const read = std::fread(buffer.get(), file_size, 1, file);
+        std::fclose(file);
+        if (read!=1) {
+            return false;
+        }
+        mapping = buffer.release();
+        mapping_size = file_size;
+#endif
+
+        // and check that its header describes it and that its rectangles are positive and within range.
+        auto const& header = *static_cast<Header const*>(mapping);
+        if (!is_valid(header, mapping_size)) {
+            close();
+            return false;
+        }
+        auto const first = static_cast<char const*>(mapping)+header_size;
+        auto const size = std::size_t(header.num_rectangles);
+        if (!((header.coordinate_width==2)
+              ? are_valid_arrays(reinterpret_cast<std::int16_t const*>(first), size)
+              : are_valid_arrays(reinterpret_cast<std::int32_t const*>(first), size))) {
+            close();
+            return false;
+        }
+        arrays = first;
+        num_rectangles = size;
+        width = int(header.coordinate_width);
+        return true;
+    }
+
+    void RectangleFile::close() noexcept
+    {
+        if (mapping!=nullptr) {
+#if defined(__unix__) || defined(__APPLE__)
+            ::munmap(mapping, mapping_size);
+#else
+            delete[] static_cast<std::uint64_t*>(mapping);
+#endif
+        }
+
+        mapping = nullptr;
+        mapping_size = 0;
+        arrays = nullptr;
+        num_rectangles = 0;
+        width = 0;
+    }
+
+    Rectangles RectangleFile::rectangles() const
+    {
+        return (width==2)
+               ? read_arrays(static_cast<std::int16_t const*>(arrays), size())
+               : read_arrays(static_cast<std::int32_t const*>(arrays), size());
+    }
+
+    bool is_rectangle_file(char const* const filename)
+    {
+        auto const file = std::fopen(filename, "rb");
+        if (file==nullptr) {
+            return false;
+        }
+        char file_magic[sizeof(magic)];
+        auto const read = std::fread(file_magic, sizeof(file_magic), 1, file);
+        std::fclose(file);
+        return read==1 && std::memcmp(file_magic, magic, sizeof(magic))==0;
+    }
+
+    bool save_rectangle_file(char const* const filename, Rectangles const& rectangles)
+    {
+        if (!is_little_endian()) {
+            return false;
+        }
+
+        // Use 16-bit coordinates if every coordinate fits.
+        auto const fits_16_bits = std::all_of(std::begin(rectangles), std::end(rectangles), [](auto const& rectangle) {
+            constexpr auto min = int(std::numeric_limits<std::int16_t>::min());
+            constexpr auto max = int(std::numeric_limits<std::int16_t>::max());
+            return rectangle.x()>=min && rectangle.x()<=max && rectangle.y()>=min && rectangle.y()<=max
+                   && rectangle.w()<=max && rectangle.h()<=max;
+        });
+
+        auto const file = std::fopen(filename, "wb");
+        if (file==nullptr) {
+            return false;
+        }
+
+        auto const header = Header{
+                {magic[0], magic[1], magic[2], magic[3]}, version, rectangles.size(),
+                std::uint32_t(fits_16_bits ? 2 : 4), 0};
+        auto const is_written = std::fwrite(&header, sizeof(header), 1, file)==1
+                                && (fits_16_bits
+                                    ? write_arrays<std::int16_t>(file, rectangles)
+                                    : write_arrays<std::int32_t>(file, rectangles));
+        return std::fclose(file)==0 && is_written;
+    }
+}
@@ -0,0 +1,222 @@
+/// \file
+/// \brief definition of RectanglesHandler, which builds rectangles from the events of a SAX parser of JSON
+
+#ifndef INTERSECTIONS_RECTANGLES_HANDLER_H
+#define INTERSECTIONS_RECTANGLES_HANDLER_H
+
+#include <intersections.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace intersections {
+    // SAX handler which appends rectangles to a vector as they are parsed from a document of the form,
+    // {"rects": [{"x": 0, "y": 0, "w": 1, "h": 1}, ...]};
+    // other members are skipped and anything else is a parse error;
+    // has the member functions of a RapidJSON handler, whose SizeType is unsigned,
+    // but does not depend on RapidJSON so that it can be tested without it
+    class RectanglesHandler {
+    public:
+        using SizeType = unsigned;
+
+        explicit RectanglesHandler(Rectangles& rectangles) noexcept
+                :rectangles(rectangles)
+        {
+        }
+
+        // true iff the document had an array of rectangles
+        bool has_rects() const noexcept
+        {
+            return has_rects_array;
+        }
+
+        // called for values other than those below
+        bool Default() noexcept
+        {
+            if (skip_depth>0) {
+                return true;
+            }
+            if (is_skipping) {
+                is_skipping = false;
+                return true;
+            }
+            return false;
+        }
+
+        bool Null() noexcept { return Default(); }
+
+        bool Bool(bool) noexcept { return Default(); }
+
+        bool Int(int const value) noexcept
+        {
+            if (field==no_field) {
+                return Default();
+            }
+
+            coordinates[field] = value;
+            fields_seen |= 1 << field;
+            field = no_field;
+            return true;
+        }
+
+        bool Uint(unsigned const value) noexcept
+        {
+            return (value<=unsigned(std::numeric_limits<int>::max())) ? Int(int(value)) : Default();
+        }
+
+        bool Int64(std::int64_t) noexcept { return Default(); }
+
+        bool Uint64(std::uint64_t) noexcept { return Default(); }
+
+        bool Double(double) noexcept { return Default(); }
+
+        bool RawNumber(char const*, SizeType, bool) noexcept { return Default(); }
+
+        bool String(char const*, SizeType, bool) noexcept { return Default(); }
+
+        bool Key(char const* const name, SizeType const length, bool) noexcept
+        {
+            if (skip_depth>0) {
+                return true;
+            }
+
+            auto const is_key = [name, length](char const* const key) {
+                return length==std::strlen(key) && std::memcmp(name, key, length)==0;
+            };
+            if (place==Place::root && is_key("rects")) {
+                is_rects_next = true;
+                return true;
+            }
+            if (place==Place::rect) {
+                for (auto n = 0; n!=4; ++n) {
+                    if (is_key(field_name(n))) {
+                        field = n;
+                        return true;
+                    }
+                }
+            }
+            is_skipping = true;
+            return true;
+        }
+
+        bool StartObject() noexcept
+        {
+            if (skip_depth>0 || is_skipping) {
+                return skip();
+            }
+
+            switch (place) {
+            case Place::document:
+                place = Place::root;
+                return true;
+            case Place::rects:
+                place = Place::rect;
+                fields_seen = 0;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool EndObject(SizeType) noexcept
+        {
+            if (skip_depth>0) {
+                --skip_depth;
+                return true;
+            }
+
+            if (place==Place::root) {
+                place = Place::end;
+                return true;
+            }
+
+            // every rectangle must have all four fields
+            assert(place==Place::rect);
+            if (fields_seen!=0xf) {
+                return false;
+            }
+            rectangles.emplace_back(coordinates[0], coordinates[1], coordinates[2], coordinates[3]);
+            place = Place::rects;
+            return true;
+        }
+
+        bool StartArray() noexcept
+        {
+            if (skip_depth>0 || is_skipping) {
+                return skip();
+            }
+            if (!is_rects_next) {
+                return false;
+            }
+
+            is_rects_next = false;
+            has_rects_array = true;
+            place = Place::rects;
+            return true;
+        }
+
+        bool EndArray(SizeType) noexcept
+        {
+            if (skip_depth>0) {
+                --skip_depth;
+                return true;
+            }
+
+            assert(place==Place::rects);
+            place = Place::root;
+            return true;
+        }
+
+    private:
+        // where in the document the parser is
+        enum class Place {
+            document,
+            root,
+            rects,
+            rect,
+            end
+        };
+
+        // begins skipping the value which is a container
+        bool skip() noexcept
+        {
+            ++skip_depth;
+            is_skipping = false;
+            return true;
+        }
+
+        // the key of coordinate n of a rectangle
+        static char const* field_name(int const n) noexcept
+        {
+            constexpr char const* field_names[4] = {"x", "y", "w", "h"};
+            return field_names[n];
+        }
+
+        static constexpr int no_field = -1;
+
+        Rectangles& rectangles;
+
+        Place place = Place::document;
+
+        // the value of the last key is the array of rectangles
+        bool is_rects_next = false;
+        bool has_rects_array = false;
+
+        // the value of the last key is to be skipped
+        bool is_skipping = false;
+
+        // the depth of nesting within a value which is being skipped
+        int skip_depth = 0;
+
+        // the index of the coordinate named by the last key within a rectangle
+        int field = no_field;
+        int coordinates[4] = {};
+
+        // bit n is set if coordinate n of the current rectangle has been read
+        int fields_seen = 0;
+    };
+}
+
+#endif //INTERSECTIONS_RECTANGLES_HANDLER_H
@@ -0,0 +1,315 @@
+/// \file
+/// \brief defines intersections::RTree
+
+#include <rtree.h>
+
+#include "bitset.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+using namespace intersections;
+
+namespace {
+    using Index = RTree::Index;
+
+    // a child of a node under construction
+    struct Entry {
+        Rectangle bounds;
+        Index index;
+    };
+
+    // twice the center of interval, which cannot overflow
+    std::int64_t double_center(Interval const& interval) noexcept
+    {
+        return std::int64_t(interval.start)+interval.end;
+    }
+
+    // the smallest rectangle which contains both rectangles
+    Rectangle bounding(Rectangle const& lhs, Rectangle const& rhs) noexcept
+    {
+        auto const bounding_interval = [&](Axis const axis) {
+            auto const& l = lhs.interval(axis);
+            auto const& r = rhs.interval(axis);
+            return Interval{std::min(l.start, r.start), std::max(l.end, r.end)};
+        };
+        return Rectangle::from_intervals(bounding_interval(Axis::horizontal), bounding_interval(Axis::vertical));
+    }
+
+    // the squared distance from point to the nearest point in bounds
+    std::int64_t squared_distance(Point const point, int x0, int x1, int y0, int y1) noexcept
+    {
+        auto const distance = [](int const position, int const start, int const end) {
+            return (position<start)
+                   ? std::int64_t(start)-position
+                   : (position>end) ? std::int64_t(position)-end : std::int64_t{0};
+        };
+        auto const dx = distance(point.x, x0, x1);
+        auto const dy = distance(point.y, y0, y1);
+        return dx*dx+dy*dy;
+    }
+
+    // returns a mask of the children of node which contain point
+    template<typename Node>
+    std::uint32_t child_mask(Node const& node, Point const point) noexcept
+    {
+        auto mask = std::uint32_t{0};
+        for (auto child = std::size_t{0}; child!=RTree::fanout; ++child) {
+            auto const is_match = (node.x0s[child]<=point.x) & (point.x<node.x1s[child])
+                                  & (node.y0s[child]<=point.y) & (point.y<node.y1s[child]);
+            mask |= std::uint32_t(is_match) << child;
+        }
+        return mask;
+    }
+
+    // returns a mask of the children of node which overlap window with positive area
+    template<typename Node>
+    std::uint32_t child_mask(Node const& node, Rectangle const& window) noexcept
+    {
+        auto const& horizontal = window.interval(Axis::horizontal);
+        auto const& vertical = window.interval(Axis::vertical);
+        auto mask = std::uint32_t{0};
+        for (auto child = std::size_t{0}; child!=RTree::fanout; ++child) {
+            auto const is_match = (node.x0s[child]<horizontal.end) & (horizontal.start<node.x1s[child])
+                                  & (node.y0s[child]<vertical.end) & (vertical.start<node.y1s[child]);
+            mask |= std::uint32_t(is_match) << child;
+        }
+        return mask;
+    }
+
+    // Sort-Tile-Recursive packing of entries into nodes which are appended to nodes;
+    // returns the entries of the new nodes
+    template<typename Nodes>
+    std::vector<Entry> pack(std::vector<Entry> entries, Nodes& nodes)
+    {
+        using Node = typename Nodes::value_type;
+        auto const by_center = [](Axis const axis) {
+            return [axis](Entry const& lhs, Entry const& rhs) {
+                return double_center(lhs.bounds.interval(axis))<double_center(rhs.bounds.interval(axis));
+            };
+        };
+
+        // Divide the entries into vertical slices of whole nodes
+        auto const num_nodes = (entries.size()+RTree::fanout-1)/RTree::fanout;
+        auto const num_slices = std::size_t(std::ceil(std::sqrt(double(num_nodes))));
+        auto const slice_size = num_slices*RTree::fanout;
+        std::sort(std::begin(entries), std::end(entries), by_center(Axis::horizontal));
+
+        std::vector<Entry> parents;
+        for (auto slice_first = std::size_t{0}; slice_first<entries.size(); slice_first += slice_size) {
+            // and each slice into nodes.
+            auto const slice_last = std::min(slice_first+slice_size, entries.size());
+            std::sort(
+                    std::begin(entries)+slice_first, std::begin(entries)+slice_last, by_center(Axis::vertical));
+
+            for (auto first = slice_first; first<slice_last; first += RTree::fanout) {
+                auto const last = std::min(first+RTree::fanout, slice_last);
+
+                // unused children contain and overlap nothing
+                Node node;
+                std::fill(std::begin(node.x0s), std::end(node.x0s), std::numeric_limits<int>::max());
+                std::fill(std::begin(node.y0s), std::end(node.y0s), std::numeric_limits<int>::max());
+                std::fill(std::begin(node.x1s), std::end(node.x1s), std::numeric_limits<int>::lowest());
+                std::fill(std::begin(node.y1s), std::end(node.y1s), std::numeric_limits<int>::lowest());
+                std::fill(std::begin(node.children), std::end(node.children), Index{0});
+                node.num_children = std::uint32_t(last-first);
+
+                auto bounds = entries[first].bounds;
+                for (auto n = first; n!=last; ++n) {
+                    auto const& entry = entries[n];
+                    auto const child = n-first;
+                    node.x0s[child] = entry.bounds.interval(Axis::horizontal).start;
+                    node.x1s[child] = entry.bounds.interval(Axis::horizontal).end;
+                    node.y0s[child] = entry.bounds.interval(Axis::vertical).start;
+                    node.y1s[child] = entry.bounds.interval(Axis::vertical).end;
+                    node.children[child] = entry.index;
+                    bounds = bounding(bounds, entry.bounds);
+                }
+
+                parents.push_back(Entry{bounds, Index(nodes.size())});
+                nodes.push_back(node);
+            }
+        }
+        return parents;
+    }
+}
+
+namespace intersections {
+    RTree::RTree(Rectangles const& rectangles)
+            :num_rectangles(rectangles.size())
+    {
+        assert(rectangles.size()<std::numeric_limits<Index>::max());
+        if (rectangles.empty()) {
+            return;
+        }
+
+        // Pack the rectangles into leaves
+        std::vector<Entry> entries;
+        entries.reserve(rectangles.size());
+        for (auto const& rectangle : rectangles) {
+            entries.push_back(Entry{rectangle, Index(entries.size())});
+        }
+        entries = pack(std::move(entries), nodes);
+        num_leaves = nodes.size();
+
+        // and the nodes of each level into the level above until there is one root.
+        while (entries.size()>1) {
+            entries = pack(std::move(entries), nodes);
+        }
+    }
+
+    std::vector<RTree::Index> RTree::containing(Point const point) const
+    {
+        return search(point);
+    }
+
+    std::vector<RTree::Index> RTree::overlapping(Rectangle const& window) const
+    {
+        return search(window);
+    }
+
+    std::vector<RTree::Index> RTree::nearest(Point const point, std::size_t const k) const
+    {
+        std::vector<Index> found;
+        if (nodes.empty()) {
+            return found;
+        }
+
+        // Visit nodes and rectangles in order of their distance from point;
+        // at equal distances, nodes are visited first so that rectangles are found in order of index.
+        enum class Kind {
+            node,
+            rectangle
+        };
+        using Candidate = std::tuple<std::int64_t, Kind, Index>;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+        candidates.emplace(0, Kind::node, Index(nodes.size()-1));
+        while (!candidates.empty() && found.size()<k) {
+            auto const candidate = candidates.top();
+            candidates.pop();
+
+            auto const index = std::get<2>(candidate);
+            if (std::get<1>(candidate)==Kind::rectangle) {
+                found.push_back(index);
+                continue;
+            }
+
+            auto const& node = nodes[index];
+            auto const kind = (index<num_leaves) ? Kind::rectangle : Kind::node;
+            for (auto child = std::size_t{0}; child!=node.num_children; ++child) {
+                auto const distance = squared_distance(
+                        point, node.x0s[child], node.x1s[child], node.y0s[child], node.y1s[child]);
+                candidates.emplace(distance, kind, node.children[child]);
+            }
+        }
+        return found;
+    }
+
+    QueryResults RTree::containing(std::vector<Point> const& points) const
+    {
+        return batch(points);
+    }
+
+    QueryResults RTree::overlapping(Rectangles const& windows) const
+    {
+        return batch(windows);
+    }
+
+    template<typename Probe>
+    std::vector<RTree::Index> RTree::search(Probe const& probe) const
+    {
+        std::vector<Index> found;
+        if (nodes.empty()) {
+            return found;
+        }
+
+        std::vector<Index> stack(1, Index(nodes.size()-1));
+        while (!stack.empty()) {
+            auto const index = stack.back();
+            stack.pop_back();
+
+            auto const& node = nodes[index];
+            auto& destination = (index<num_leaves) ? found : stack;
+            for (auto mask = child_mask(node, probe); mask!=0; mask &= mask-1) {
+                destination.push_back(node.children[count_trailing_zeros(mask)]);
+            }
+        }
+
+        std::sort(std::begin(found), std::end(found));
+        return found;
+    }
+
+    template<typename Probe>
+    QueryResults RTree::batch(std::vector<Probe> const& probes) const
+    {
+        assert(probes.size()<std::numeric_limits<Index>::max());
+
+        // pairs of probe and rectangle
+        std::vector<std::pair<Index, Index>> found;
+        if (!nodes.empty()) {
+            // Descend the tree depth-first with the probes which reach each node;
+            // the probes of a node are a range of buffer which lies below the probes of nodes visited later.
+            struct Visit {
+                Index node;
+                std::size_t first;
+                std::size_t last;
+            };
+            std::vector<Index> buffer(probes.size());
+            std::iota(std::begin(buffer), std::end(buffer), Index{0});
+            std::vector<Visit> stack(1, Visit{Index(nodes.size()-1), 0, buffer.size()});
+            std::vector<std::uint32_t> masks;
+            while (!stack.empty()) {
+                auto const visit = stack.back();
+                stack.pop_back();
+                buffer.resize(visit.last);
+
+                // Test each probe against every child at once
+                auto const& node = nodes[visit.node];
+                masks.clear();
+                for (auto n = visit.first; n!=visit.last; ++n) {
+                    masks.push_back(child_mask(node, probes[buffer[n]]));
+                }
+
+                // and report the rectangles they match
+                if (visit.node<num_leaves) {
+                    for (auto n = visit.first; n!=visit.last; ++n) {
+                        for (auto mask = masks[n-visit.first]; mask!=0; mask &= mask-1) {
+                            found.emplace_back(buffer[n], node.children[count_trailing_zeros(mask)]);
+                        }
+                    }
+                    continue;
+                }
+
+                // or gather the probes which reach each child.
+                for (auto child = std::size_t{0}; child!=node.num_children; ++child) {
+                    auto const first = buffer.size();
+                    for (auto n = visit.first; n!=visit.last; ++n) {
+                        if ((masks[n-visit.first] >> child) & 1) {
+                            buffer.push_back(buffer[n]);
+                        }
+                    }
+                    if (buffer.size()!=first) {
+                        stack.push_back(Visit{node.children[child], first, buffer.size()});
+                    }
+                }
+            }
+        }
+
+        // Finally, gather the matches of each probe in order.
+        std::sort(std::begin(found), std::end(found));
+        std::vector<std::size_t> offsets(probes.size()+1, 0);
+        std::vector<Index> indices;
+        indices.reserve(found.size());
+        for (auto const& match : found) {
+            ++offsets[match.first+1];
+            indices.push_back(match.second);
+        }
+        std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+        return QueryResults(std::move(offsets), std::move(indices));
+    }
+}
@@ -5,84 +5,122 @@
 /// \file
 /// \brief defines intersections::solve and supporting functions and types
 
-#include <intersections.h>
+#include <rectangle_batch.h>
+
+#include "bitset.h"
 
 #include <functional>
 
 using namespace intersections;
 
 namespace {
-    using RectanglesIterator = typename Rectangles::const_iterator;
-    using RectangleSequence = std::vector<Rectangle const*>;
-
-    void submit(Intersections& intersections, RectangleSequence const& constituents, Rectangle const overlap)
+    // state which is common to every step of the recursion of intersections::solve<Solution::simple>
+    struct Recursion {
+        Rectangles const& rectangles;
+        RectangleBatch const& batch;
+        RectangleSequence& constituents;
+        RectangleSequence& excluded;
+        Visitor const& visitor;
+        SolveOptions const& options;
+
+        // the number of overlaps reported so far
+        std::size_t num_results;
+    };
+
+    // helper function for intersections::solve<Solution::simple>;
+    // candidates is the mask of the remaining rectangles in the given word of recursion.batch
+    // which overlap the overlap
+    void recurse(Recursion& recursion, std::size_t word, std::uint64_t candidates, Rectangle const overlap)
     {
-        auto const found = intersections.find(overlap);
-
-        // If this area of overlap is already represented,
-        if (found!=std::end(intersections)) {
-            // then it's by a super-set of rectangles
-            assert(std::includes(
-                    std::begin(found->second), std::end(found->second),
-                    std::begin(constituents), std::end(constituents)));
-
-            // that's greater.
-            assert(std::distance(std::begin(found->second), std::end(found->second))
-                    >int(constituents.size()));
-
+        // Rectangles are only added, so the overlap only shrinks
+        // and the constituents can be no more than those included plus those remaining.
+        auto const& options = recursion.options;
+        if (recursion.num_results>=options.max_results) {
+            return;
+        }
+        record(options.stats, &SolveStats::Counters::recursion_nodes);
+        if (!recursion.constituents.empty() && std::int64_t(overlap.w())*overlap.h()<options.min_area) {
+            record(options.stats, &SolveStats::Counters::recursion_pruned);
+            return;
+        }
+        auto const& batch = recursion.batch;
+        auto const num_later = batch.size()-std::min(batch.size(), (word+1)*RectangleBatch::rectangles_per_word);
+        if (recursion.constituents.size()+popcount(candidates)+num_later<options.min_constituents) {
+            record(options.stats, &SolveStats::Counters::recursion_pruned);
             return;
         }
 
-        // Otherwise, add it.
-        intersections.emplace(overlap, constituents);
-    }
-
-    // helper function for intersections::combinations
-    void recurse(
-            RectanglesIterator const first, RectanglesIterator const last,
-            RectangleSequence& constituents, Rectangle const overlap,
-            Intersections& intersections)
-    {
-        auto const remaining = std::distance(first, last);
-
-        // leaf condition
-        if (remaining==0) {
-            if (constituents.size()>=2) {
-                submit(intersections, constituents, overlap);
+        // Rectangles which do not overlap the overlap can neither be included nor contain it
+        // so skip to the next rectangle which does.
+        while (candidates==0) {
+            // leaf condition
+            if (++word>=recursion.batch.num_words()) {
+                auto const& constituents = recursion.constituents;
+                if (constituents.size()<options.min_constituents) {
+                    return;
+                }
+
+                // If an excluded rectangle contains the overlap,
+                // the overlap is reported by the combination which includes it.
+                auto const& excluded = recursion.excluded;
+                if (std::any_of(std::begin(excluded), std::end(excluded), [overlap](auto const rectangle) {
+                    return contains(*rectangle, overlap);
+                })) {
+                    record(options.stats, &SolveStats::Counters::duplicates_discarded);
+                    return;
+                }
+
+                recursion.visitor(overlap, constituents);
+                ++recursion.num_results;
+                return;
             }
-            return;
+
+            candidates = overlap_word(recursion.batch, word, overlap);
         }
 
-        auto const next = std::next(first);
+        auto const index = word*RectangleBatch::rectangles_per_word+count_trailing_zeros(candidates);
+        auto const remaining = candidates & (candidates-1);
 
         // recurse with rectangle included
-        auto const& first_rectangle = *first;
+        auto const& first_rectangle = recursion.rectangles[index];
         auto const next_overlap = overlap & first_rectangle;
-        if (is_positive(next_overlap)) {
-            constituents.push_back(&first_rectangle);
-            recurse(next, last, constituents, next_overlap, intersections);
-            constituents.pop_back();
+        assert(is_positive(next_overlap));
+        recursion.constituents.push_back(&first_rectangle);
+        recurse(
+                recursion, word, remaining ? remaining & overlap_word(recursion.batch, word, next_overlap) : 0,
+                next_overlap);
+        recursion.constituents.pop_back();
+
+        // recurse with rectangle excluded;
+        // the overlap only shrinks so if the rectangle contains it, it will contain it at every leaf
+        if (!contains(first_rectangle, overlap)) {
+            recursion.excluded.push_back(&first_rectangle);
+            recurse(recursion, word, remaining, overlap);
+            recursion.excluded.pop_back();
         }
-
-        // recurse with rectangle excluded
-        recurse(next, last, constituents, overlap, intersections);
     }
 }
 
 namespace intersections {
     template<>
-    Intersections solve<Solution::simple>(Rectangles const& rectangles)
+    void solve<Solution::simple>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
     {
         // all input rectangles must have positive area
-        auto const first = std::begin(rectangles);
-        auto const last = std::end(rectangles);
-        assert(std::all_of(first, last, is_positive));
-
-        RectangleSequence constituents;
-        Intersections intersections;
-
-        recurse(first, last, constituents, maximum_rectangle, intersections);
-
-        return intersections;
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        Arena::Scope const scope(&arena);
+        SolveRecorder recorder(options.stats, arena);
+
+        // the recursion is never deeper than the number of rectangles
+        RectangleSequence constituents(&arena);
+        RectangleSequence excluded(&arena);
+        constituents.reserve(rectangles.size());
+        excluded.reserve(rectangles.size());
+
+        auto const batch = RectangleBatch(rectangles, &arena);
+        auto recursion = Recursion{rectangles, batch, constituents, excluded, visitor, options, 0};
+        recorder.begin(&SolveStats::sweep_seconds);
+        recurse(recursion, 0, batch.empty() ? 0 : overlap_word(batch, 0, maximum_rectangle), maximum_rectangle);
     }
 }
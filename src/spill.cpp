@@ -0,0 +1,329 @@
+/// \file
+/// \brief defines intersections::solve_sorted
+
+#include <spill.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+using namespace intersections;
+
+namespace {
+    // results are stored in memory and on disk as records of words:
+    // the start and end of the horizontal and vertical intervals of the overlap,
+    // the number of constituents and then their indices in the input rectangles
+    using Word = std::uint32_t;
+
+    // the words of a record before its constituents
+    constexpr std::size_t header_words = 5;
+
+    // the most runs which are merged at once;
+    // if there are more, they are first merged into fewer, longer runs
+    constexpr std::size_t max_fan_in = 64;
+
+    Rectangle overlap_of(Word const* const record) noexcept
+    {
+        return Rectangle::from_intervals(
+                Interval{int(record[0]), int(record[1])}, Interval{int(record[2]), int(record[3])});
+    }
+
+    std::size_t size_of(Word const* const record) noexcept
+    {
+        return header_words+record[4];
+    }
+
+    // a sorted run of records in a file which is deleted when the run is destroyed
+    class Run {
+    public:
+        explicit Run(std::string const& directory)
+        {
+            if (directory.empty()) {
+                file = std::tmpfile();
+                if (file==nullptr) {
+                    throw std::runtime_error("intersections::solve_sorted: error creating temporary file");
+                }
+                return;
+            }
+
+            // names are unique between processes by a random token and within a process by a count
+            static std::atomic<unsigned> count{0};
+            path = directory+"/intersections-"+std::to_string(std::random_device{}())+"-"
+                   +std::to_string(count++)+".run";
+            file = std::fopen(path.c_str(), "w+b");
+            if (file==nullptr) {
+                throw std::runtime_error("intersections::solve_sorted: error creating run file, \""+path+"\"");
+            }
+        }
+
+        Run(Run const&) = delete;
+
+        Run& operator=(Run const&) = delete;
+
+        ~Run()
+        {
+            std::fclose(file);
+            if (!path.empty()) {
+                std::remove(path.c_str());
+            }
+        }
+
+        void write(Word const* const record)
+        {
+            auto const size = size_of(record);
+            if (std::fwrite(record, sizeof(Word), size, file)!=size) {
+                throw std::runtime_error("intersections::solve_sorted: error writing run");
+            }
+        }
+
+        // prepares a run which has been written to be read from the start
+        void rewind()
+        {
+            if (std::fflush(file)!=0 || std::fseek(file, 0, SEEK_SET)!=0) {
+                throw std::runtime_error("intersections::solve_sorted: error rewinding run");
+            }
+        }
+
+        // reads the next record into record; returns false at the end of the run
+        bool read(std::vector<Word>& record)
+        {
+            record.resize(header_words);
+            auto const num_read = std::fread(record.data(), sizeof(Word), header_words, file);
+            if (num_read==0 && std::feof(file)) {
+                return false;
+            }
+
+            auto const num_constituents = std::size_t(record[4]);
+            record.resize(header_words+num_constituents);
+            if (num_read!=header_words
+                    || std::fread(record.data()+header_words, sizeof(Word), num_constituents, file)!=num_constituents) {
+                throw std::runtime_error("intersections::solve_sorted: error reading run");
+            }
+            return true;
+        }
+
+    private:
+        std::FILE* file = nullptr;
+
+        // if not empty, the file is deleted on destruction
+        std::string path;
+    };
+
+    using Runs = std::vector<std::unique_ptr<Run>>;
+
+    // results held in memory, within a budget which is allocated up-front
+    class Buffer {
+    public:
+        // a buffer which grows as results are added until they fill the budget;
+        // a record of a pair of constituents takes seven words and its start takes one
+        explicit Buffer(std::size_t const budget)
+                :max_words(std::min(budget/sizeof(Word)/8*7, std::size_t(std::numeric_limits<Word>::max()))),
+                 max_starts(budget/sizeof(Word)/8)
+        {
+        }
+
+        auto empty() const noexcept
+        {
+            return starts.empty();
+        }
+
+        // add a result whose constituents point into the sequence beginning at first;
+        // returns false if it does not fit within the budget
+        bool push_back(Rectangle const& overlap, RectangleSequence const& constituents, Rectangle const* first)
+        {
+            auto const record_words = header_words+constituents.size();
+            if (words.size()+record_words>max_words || starts.size()==max_starts) {
+                return false;
+            }
+            grow(words, words.size()+record_words, max_words);
+            grow(starts, starts.size()+1, max_starts);
+
+            starts.push_back(Word(words.size()));
+            auto const& horizontal = overlap.interval(Axis::horizontal);
+            auto const& vertical = overlap.interval(Axis::vertical);
+            for (auto const coordinate : {horizontal.start, horizontal.end, vertical.start, vertical.end}) {
+                words.push_back(Word(coordinate));
+            }
+            words.push_back(Word(constituents.size()));
+            for (auto const constituent : constituents) {
+                words.push_back(Word(constituent-first));
+            }
+            return true;
+        }
+
+        // calls function with each record in order of overlap;
+        // of the records with the same overlap, only the first to be added is passed
+        template<typename Function>
+        void for_each_sorted(Function function)
+        {
+            auto const data = words.data();
+            std::sort(std::begin(starts), std::end(starts), [data](Word const lhs, Word const rhs) {
+                auto const lhs_overlap = overlap_of(data+lhs);
+                auto const rhs_overlap = overlap_of(data+rhs);
+                return lhs_overlap<rhs_overlap || (lhs_overlap==rhs_overlap && lhs<rhs);
+            });
+
+            for (auto n = std::size_t{0}; n!=starts.size(); ++n) {
+                if (n==0 || overlap_of(data+starts[n])!=overlap_of(data+starts[n-1])) {
+                    function(data+starts[n]);
+                }
+            }
+        }
+
+        void clear() noexcept
+        {
+            words.clear();
+            starts.clear();
+        }
+
+    private:
+        // makes room for at least size values, doubling the capacity of values but not beyond max_size
+        static void grow(std::vector<Word>& values, std::size_t const size, std::size_t const max_size)
+        {
+            if (size>values.capacity()) {
+                values.reserve(std::min(std::max(size, values.capacity()*2), max_size));
+            }
+        }
+
+        std::size_t max_words;
+        std::size_t max_starts;
+
+        std::vector<Word> words;
+
+        // the index in words of each record
+        std::vector<Word> starts;
+    };
+
+    // calls function with each record of the given runs in order of overlap;
+    // of the records with the same overlap, only the one from the earliest run is passed
+    template<typename Function>
+    void merge(Runs::iterator const first, Runs::iterator const last, Function function)
+    {
+        auto const num_runs = std::size_t(last-first);
+        std::vector<std::vector<Word>> records(num_runs);
+
+        // the runs which have records left, in a heap ordered by their next record and then by run
+        std::vector<std::size_t> heap;
+        auto const is_later = [&records](std::size_t const lhs, std::size_t const rhs) {
+            auto const lhs_overlap = overlap_of(records[lhs].data());
+            auto const rhs_overlap = overlap_of(records[rhs].data());
+            return rhs_overlap<lhs_overlap || (lhs_overlap==rhs_overlap && rhs<lhs);
+        };
+        for (auto n = std::size_t{0}; n!=num_runs; ++n) {
+            if (first[n]->read(records[n])) {
+                heap.push_back(n);
+            }
+        }
+        std::make_heap(std::begin(heap), std::end(heap), is_later);
+
+        auto previous = Rectangle{};
+        auto is_first = true;
+        while (!heap.empty()) {
+            std::pop_heap(std::begin(heap), std::end(heap), is_later);
+            auto const n = heap.back();
+            auto const overlap = overlap_of(records[n].data());
+            if (is_first || overlap!=previous) {
+                function(records[n].data());
+                previous = overlap;
+                is_first = false;
+            }
+
+            if (first[n]->read(records[n])) {
+                std::push_heap(std::begin(heap), std::end(heap), is_later);
+            }
+            else {
+                heap.pop_back();
+            }
+        }
+    }
+}
+
+namespace intersections {
+    void solve_sorted(
+            Rectangles const& rectangles, Visitor const& visitor,
+            void (* const solver)(Rectangles const&, Visitor const&, SolveOptions const&, Arena&),
+            SpillOptions const& spill, SolveOptions const& options)
+    {
+        assert(rectangles.size()<=std::numeric_limits<Word>::max());
+
+        auto buffer = Buffer(spill.memory_budget);
+        Runs runs;
+        auto const new_run = [&runs, &spill]() -> Run& {
+            runs.push_back(std::make_unique<Run>(spill.directory));
+            return *runs.back();
+        };
+
+        // Collect the results, writing them to disk in sorted runs whenever they exceed the budget,
+        auto const first = rectangles.data();
+        Arena arena;
+        solver(rectangles, [&](Rectangle const& overlap, RectangleSequence const& constituents) {
+            if (buffer.push_back(overlap, constituents, first)) {
+                return;
+            }
+
+            auto& run = new_run();
+            buffer.for_each_sorted([&run](Word const* const record) {
+                run.write(record);
+            });
+            run.rewind();
+            buffer.clear();
+
+            if (!buffer.push_back(overlap, constituents, first)) {
+                throw std::length_error("intersections::solve_sorted: result exceeds memory_budget");
+            }
+        }, options, arena);
+
+        RectangleSequence constituents(&arena);
+        constituents.reserve(rectangles.size());
+        auto const report = [&](Word const* const record) {
+            constituents.clear();
+            for (auto index = record+header_words; index!=record+size_of(record); ++index) {
+                constituents.push_back(&rectangles[*index]);
+            }
+            visitor(overlap_of(record), constituents);
+        };
+
+        // and if none were written, report them straight from memory.
+        if (runs.empty()) {
+            buffer.for_each_sorted(report);
+            return;
+        }
+
+        // Otherwise, write the remainder and free the buffer
+        if (!buffer.empty()) {
+            auto& run = new_run();
+            buffer.for_each_sorted([&run](Word const* const record) {
+                run.write(record);
+            });
+            run.rewind();
+        }
+        buffer = Buffer(0);
+
+        // and merge the runs into fewer, longer runs until few enough remain to be merged into the results.
+        while (runs.size()>max_fan_in) {
+            auto merged = Runs{};
+            for (auto group = std::begin(runs); group!=std::end(runs);) {
+                auto const group_end = group+std::min(max_fan_in, std::size_t(std::end(runs)-group));
+                merged.push_back(std::make_unique<Run>(spill.directory));
+                auto& run = *merged.back();
+                merge(group, group_end, [&run](Word const* const record) {
+                    run.write(record);
+                });
+                run.rewind();
+
+                // Runs are deleted once merged so that at most one extra copy of the results is on disk.
+                for (; group!=group_end; ++group) {
+                    group->reset();
+                }
+            }
+            runs = std::move(merged);
+        }
+        merge(std::begin(runs), std::end(runs), report);
+    }
+}
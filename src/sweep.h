@@ -0,0 +1,233 @@
+/// \file
+/// \brief the plane sweep shared by the variants of the fast solution
+
+#ifndef INTERSECTIONS_SWEEP_H
+#define INTERSECTIONS_SWEEP_H
+
+#include "bitset.h"
+#include "transitions.h"
+
+#include <numeric>
+
+namespace intersections {
+    // set of the rectangles which span a horizontal range
+    // which also counts how many of them have edges at the edges of that range
+    // so that it can tell in constant time whether their overlap shares those edges
+    class SpanningRectangleBitset {
+    public:
+        // an empty set which can hold any of the rectangles in no_rectangles
+        SpanningRectangleBitset(RectangleBitset const& no_rectangles, Interval const horizontal_range)
+                :rectangles(no_rectangles), horizontal_range(horizontal_range)
+        {
+            assert(no_rectangles.empty());
+        }
+
+        auto empty() const noexcept
+        {
+            return rectangles.empty();
+        }
+
+        auto size() const noexcept
+        {
+            return rectangles.size();
+        }
+
+        Arena* arena() const noexcept
+        {
+            return rectangles.arena();
+        }
+
+        // true iff the overlap of the rectangles spans exactly the horizontal range
+        bool has_horizontal_edges() const noexcept
+        {
+            return num_starting>0 && num_ending>0;
+        }
+
+        void insert(Rectangle const* rectangle) noexcept
+        {
+            if (rectangles.insert(rectangle)) {
+                count(rectangle, 1);
+            }
+        }
+
+        void erase(Rectangle const* rectangle) noexcept
+        {
+            if (rectangles.erase(rectangle)) {
+                count(rectangle, -1);
+            }
+        }
+
+        auto begin() const noexcept
+        {
+            return std::begin(rectangles);
+        }
+
+        auto end() const noexcept
+        {
+            return std::end(rectangles);
+        }
+
+    private:
+        void count(Rectangle const* rectangle, int const delta) noexcept
+        {
+            auto const& interval = rectangle->interval(Axis::horizontal);
+            assert(interval.start<=horizontal_range.start && interval.end>=horizontal_range.end);
+            num_starting += delta*(interval.start==horizontal_range.start);
+            num_ending += delta*(interval.end==horizontal_range.end);
+        }
+
+        RectangleBitset rectangles;
+        Interval horizontal_range;
+
+        // the number of rectangles in the set which start at the start of horizontal_range
+        int num_starting = 0;
+
+        // the number of rectangles in the set which end at the end of horizontal_range
+        int num_ending = 0;
+    };
+
+    // Given the rectangles which are open at the position of open_iterator,
+    // call the given function for combinations of at least min_size of them that span a common range
+    // and for the range that they span.
+    // Only ranges whose edges are edges of rectangles in the combination are visited
+    // as other ranges cannot be the edges of an area of overlap.
+    template<Axis axis, typename Container, typename Iterator, typename Function>
+    void for_each_closing_range(
+            Iterator const open_iterator, Iterator const last, Container const& opening_rectangles,
+            std::size_t const min_size, Function& function)
+    {
+        // last is only needed by assertions
+        static_cast<void>(last);
+
+        auto const open_position = open_iterator->position;
+
+        // the number of rectangles in the set which start at the opening position
+        auto num_starting = open_iterator->starting.size();
+
+        // everything allocated below is discarded on return
+        Arena::Scope const scope(opening_rectangles.arena());
+
+        // sweep through the remaining rectangle edges
+        // and while there there are still at least min_size rectangles in the set
+        // including one which starts at the opening position,
+        assert(min_size>=2);
+        auto closing_rectangles = opening_rectangles;
+        for (auto close_iterator = std::next(open_iterator);
+             std::size_t(closing_rectangles.size())>=min_size && num_starting>0;
+             ++close_iterator) {
+            assert(close_iterator!=last);
+
+            // then for rectangles in the set with closing edges,
+            auto const& close = *close_iterator;
+            auto const is_in_set = [open_position](auto const rectangle) {
+                return rectangle->interval(axis).start<=open_position;
+            };
+            if (std::any_of(std::begin(close.ending), std::end(close.ending), is_in_set)) {
+                // call the given function object.
+                function(closing_rectangles, Interval{open_position, close_iterator->position});
+
+                // Remove rectangles with closing edges from the opening_rectangles set.
+                for (auto const ending_rectangle : close.ending) {
+                    closing_rectangles.erase(ending_rectangle);
+                    num_starting -= (ending_rectangle->interval(axis).start==open_position);
+                }
+            }
+        }
+    }
+
+    // Update the set of open rectangles with the edges at the position of open_iterator
+    // and if rectangles open there, sweep through the ranges that they span.
+    template<Axis axis, typename Container, typename Iterator, typename Function>
+    void for_each_range_from(
+            Iterator const open_iterator, Iterator const last, Container& opening_rectangles,
+            std::size_t const min_size, Function& function)
+    {
+        auto const& open = *open_iterator;
+
+        // remove rectangles with closing edges from the opening_rectangles set
+        for (auto const ending_rectangle : open.ending) {
+            opening_rectangles.erase(ending_rectangle);
+        }
+
+        // and for opening edges,
+        if (!open.starting.empty()) {
+            for (auto const starting_rectangle : open.starting) {
+                // add them to the set
+                opening_rectangles.insert(starting_rectangle);
+            }
+
+            for_each_closing_range<axis>(open_iterator, last, opening_rectangles, min_size, function);
+        }
+    }
+
+    // Given a set of rectangle edges aligned along an particular axis,
+    // call the given function for combinations of at least min_size rectangles that span a common range
+    // and for the range that they span;
+    // combinations are held in copies of opening_rectangles, which must be empty.
+    template<typename Container, typename Transitions, typename Function>
+    void for_each_range(
+            Transitions const& transitions, Container opening_rectangles, std::size_t const min_size,
+            Function function)
+    {
+        assert(opening_rectangles.empty());
+
+        // For each position at which rectangle edges occur,
+        auto horizontal_end = std::end(transitions);
+        for (auto open_iterator = std::begin(transitions); open_iterator!=horizontal_end; ++open_iterator) {
+            for_each_range_from<Transitions::transition_axis>(
+                    open_iterator, horizontal_end, opening_rectangles, min_size, function);
+        }
+        assert(opening_rectangles.empty());
+    }
+
+    // Given the rectangles which span a horizontal range,
+    // call the given function once for each distinct area of overlap within the limits of options
+    // whose horizontal edges are the edges of that range;
+    // no_rectangles is an empty set which can hold any of the rectangles.
+    template<typename Function>
+    void for_each_overlap(
+            Transitions<Axis::vertical> const& vertical_transitions, Interval const horizontal_range,
+            RectangleBitset const& no_rectangles, SolveOptions const& options, Function function)
+    {
+        // No overlap within the range can have more rectangles or be taller than those which span it.
+        if (std::size_t(vertical_transitions.size())<options.min_constituents) {
+            return;
+        }
+        auto const max_height = length(vertical_transitions.extent());
+        if (std::int64_t(length(horizontal_range))*max_height<options.min_area) {
+            return;
+        }
+
+        // for each vertical sub-range,
+        for_each_range(
+                vertical_transitions, SpanningRectangleBitset(no_rectangles, horizontal_range),
+                options.min_constituents,
+                [&function, &options, horizontal_range](
+                        auto const& overlapping_rectangles, Interval const vertical_range) {
+                    record(options.stats, &SolveStats::Counters::sweep_callbacks);
+
+                    // The overlap is found in every range that it covers
+                    // but is only reported in the range whose edges are its own.
+                    // The vertical edges of the range are always those of the overlap
+                    // as for_each_closing_range only visits ranges which are edges of the combination.
+                    if (!overlapping_rectangles.has_horizontal_edges()) {
+                        record(options.stats, &SolveStats::Counters::duplicates_discarded);
+                        return;
+                    }
+
+                    auto const overlap = Rectangle::from_intervals(horizontal_range, vertical_range);
+                    AXIOM(overlap==std::accumulate(
+                            std::begin(overlapping_rectangles), std::end(overlapping_rectangles),
+                            maximum_rectangle, [](auto accumulation, auto const* rectangle) {
+                                return accumulation & *rectangle;
+                            }));
+                    assert(is_positive(overlap));
+
+                    if (accepts(options, overlap, overlapping_rectangles.size())) {
+                        function(overlap, overlapping_rectangles);
+                    }
+                });
+    }
+}
+
+#endif //INTERSECTIONS_SWEEP_H
@@ -5,19 +5,53 @@
 /// \file
 /// \brief basic tests of the functionality provided via the intersections::solve API
 
-#include <intersections.h>
-
+#include <cliques.h>
+#include <compact_intersections.h>
+#include <cost_model.h>
+#include <coverage.h>
+#include <depth.h>
+#include <grid.h>
+#include <incremental.h>
+#include <overlap_graph.h>
+#include <rectangle_batch.h>
+#include <rectangle_file.h>
+#include <rtree.h>
+#include <spill.h>
+
+#include "bitset.h"
+#include "parallel_for.h"
+#include "rectangles_handler.h"
+#include "transitions.h"
+
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <numeric>
 #include <random>
+#include <stdexcept>
+#include <tuple>
 #include <unordered_set>
 
+using intersections::Arena;
+using intersections::CompactIntersections;
 using intersections::RectangleSequence;
 using intersections::Intersections;
+using intersections::Isa;
 using intersections::Interval;
 using intersections::Rectangle;
+using intersections::RectangleBatch;
 using intersections::Rectangles;
 using intersections::Solution;
+using intersections::SolveOptions;
+using intersections::SolveStats;
+using intersections::SpillOptions;
+using intersections::Visitor;
 using intersections::solve;
+using intersections::solve_sorted;
 
 // simple assert macro designed for facilitating tests
 #define TEST_ASSERT(CONDITION) \
@@ -478,6 +512,122 @@ namespace {
         TEST_ASSERT(expected==actual);
     }
 
+    template<Solution solution>
+    void test_visitor()
+    {
+        auto rectangles = Rectangles{
+                Rectangle {0, 0, 3, 2},
+                Rectangle {1, 0, 2, 3},
+                Rectangle {1, 1, 2, 2},
+                Rectangle {0, 0, 2, 3}};
+        auto expected = solve<solution>(rectangles);
+
+        // every overlap is visited exactly once
+        auto actual = Intersections{};
+        auto num_visits = 0;
+        solve<solution>(rectangles, [&](Rectangle const& overlap, RectangleSequence const& constituents) {
+            actual.emplace(overlap, constituents);
+            ++num_visits;
+        });
+        TEST_ASSERT(expected==actual);
+        TEST_ASSERT(num_visits==int(expected.size()));
+    }
+
+    template<Solution solution>
+    void test_compact()
+    {
+        auto rectangles = Rectangles{
+                Rectangle {100, 100, 250, 80},
+                Rectangle {120, 200, 250, 150},
+                Rectangle {140, 160, 250, 100},
+                Rectangle {160, 140, 350, 190}};
+        auto expected = solve<solution>(rectangles);
+
+        auto actual = CompactIntersections{};
+        solve<solution>(rectangles, actual);
+        TEST_ASSERT(actual.size()==expected.size());
+        TEST_ASSERT(to_intersections(actual, rectangles)==expected);
+
+        // constituents are in input order
+        for (auto n = std::size_t{0}; n!=actual.size(); ++n) {
+            auto const constituents = actual.constituents(n);
+            TEST_ASSERT(constituents.size()>=2);
+            TEST_ASSERT(std::is_sorted(std::begin(constituents), std::end(constituents)));
+        }
+
+        actual.clear();
+        TEST_ASSERT(actual.empty());
+    }
+
+    template<Solution solution>
+    void test_arena()
+    {
+        auto rectangles = Rectangles{
+                Rectangle {100, 100, 250, 80},
+                Rectangle {120, 200, 250, 150},
+                Rectangle {140, 160, 250, 100},
+                Rectangle {160, 140, 350, 190}};
+        auto expected = solve<solution>(rectangles);
+
+        // a tiny block size forces the arena to grow
+        Arena arena(64);
+        auto actual = CompactIntersections{};
+        solve<solution>(rectangles, actual, arena);
+        TEST_ASSERT(to_intersections(actual, rectangles)==expected);
+
+        // once the arena has grown, repeating the solve takes no more memory
+        auto const capacity = arena.capacity();
+        TEST_ASSERT(capacity>0);
+        for (auto repetition = 0; repetition!=3; ++repetition) {
+            actual.clear();
+            solve<solution>(rectangles, actual, arena);
+            TEST_ASSERT(to_intersections(actual, rectangles)==expected);
+            TEST_ASSERT(arena.capacity()==capacity);
+        }
+
+        // reset merges blocks without losing capacity
+        arena.reset();
+        TEST_ASSERT(arena.capacity()==capacity);
+        actual.clear();
+        solve<solution>(rectangles, actual, arena);
+        TEST_ASSERT(to_intersections(actual, rectangles)==expected);
+        TEST_ASSERT(arena.capacity()==capacity);
+    }
+
+    void test_flat_map()
+    {
+        // many similar keys, as produced by solve
+        auto map = intersections::FlatMap<Rectangle, int>{};
+        for (auto n = 0; n!=1000; ++n) {
+            TEST_ASSERT(map.emplace(Rectangle{n%10, n/10, 1, 1}, n).second);
+        }
+        TEST_ASSERT(map.size()==1000);
+        TEST_ASSERT(!map.emplace(Rectangle{0, 0, 1, 1}, -1).second);
+        TEST_ASSERT(map.find(Rectangle{0, 0, 1, 1})->second==0);
+
+        // erase every other entry
+        for (auto n = 0; n!=1000; n += 2) {
+            TEST_ASSERT(map.erase(Rectangle{n%10, n/10, 1, 1})==1);
+        }
+        TEST_ASSERT(map.erase(Rectangle{0, 0, 1, 1})==0);
+        TEST_ASSERT(map.size()==500);
+        for (auto n = 0; n!=1000; ++n) {
+            auto const found = map.find(Rectangle{n%10, n/10, 1, 1});
+            TEST_ASSERT((found==std::end(map))==(n%2==0));
+            TEST_ASSERT(found==std::end(map) || found->second==n);
+        }
+        TEST_ASSERT(std::distance(std::begin(map), std::end(map))==500);
+
+        auto copy = map;
+        TEST_ASSERT(copy==map);
+        copy.erase(Rectangle{1, 0, 1, 1});
+        TEST_ASSERT(copy!=map);
+
+        map.clear();
+        TEST_ASSERT(map.empty());
+        TEST_ASSERT(std::begin(map)==std::end(map));
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     // "heavy" unit test: procedural stress test
 
@@ -636,18 +786,1100 @@ namespace {
         TEST_ASSERT(speed_checksum==correctness_checksum);
     }
 
+    // check that two solutions produce identical results from the same random input
+    template<Solution solution1, Solution solution2>
+    void test_agreement(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            TEST_ASSERT(solve<solution1>(rectangles)==solve<solution2>(rectangles));
+        }
+    }
+
+    // check that two solutions visit identical results in identical order
+    template<Solution solution1, Solution solution2>
+    void test_visit_order(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        using Visits = std::vector<std::pair<Rectangle, RectangleSequence>>;
+        auto record = [](Visits& visits) {
+            return [&visits](Rectangle const& overlap, RectangleSequence const& constituents) {
+                visits.emplace_back(overlap, constituents);
+            };
+        };
+
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            Visits visits1, visits2;
+            solve<solution1>(rectangles, record(visits1));
+            solve<solution2>(rectangles, record(visits2));
+            TEST_ASSERT(visits1==visits2);
+        }
+    }
+
+    // check that the tiled solution agrees with the fast solution on large, sparse layouts
+    // in which many overlaps straddle the borders between tiles
+    void test_tiled(int num_samples, int num_rectangles, int max_extent)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            auto const spread = max_extent*(sample+1)*10;
+            std::uniform_int_distribution<int> position_distribution(-spread, spread);
+            std::uniform_int_distribution<int> extent_distribution(1, max_extent);
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return Rectangle{
+                        position_distribution(gen), position_distribution(gen),
+                        extent_distribution(gen), extent_distribution(gen)};
+            });
+
+            // including some which span several tiles
+            rectangles.push_back(Rectangle{-spread, 0, spread*2, max_extent});
+            rectangles.push_back(Rectangle{0, -spread, max_extent, spread*2});
+
+            TEST_ASSERT(solve<Solution::tiled>(rectangles)==solve<Solution::fast>(rectangles));
+        }
+    }
+
+    // check that radix_sort matches std::stable_sort, including bytes which are the same in every key
+    void test_radix_sort(int num_samples, std::size_t max_size)
+    {
+        std::mt19937_64 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            // each byte of the keys either varies over a few values or is the same in every key;
+            // when every byte is the same, every pass is skipped
+            auto const size = std::size_t(gen()%(max_size+1));
+            auto const varying_bytes = (sample%10==0) ? 0 : gen();
+            auto const fixed_bytes = gen();
+            Rectangles rectangles(size);
+            std::vector<std::pair<std::uint64_t, Rectangle const*>> expected;
+            for (auto const& rectangle : rectangles) {
+                auto key = std::uint64_t{0};
+                for (auto byte = 0; byte!=8; ++byte) {
+                    auto const value = ((varying_bytes >> byte) & 1) ? gen()%3*0x7f : (fixed_bytes >> (byte*8)) & 0xff;
+                    key |= value << (byte*8);
+                }
+                expected.emplace_back(key, &rectangle);
+            }
+
+            Arena arena;
+            intersections::ArenaVector<std::uint64_t> keys(&arena);
+            intersections::ArenaVector<Rectangle const*> values(&arena);
+            for (auto const& entry : expected) {
+                keys.push_back(entry.first);
+                values.push_back(entry.second);
+            }
+            intersections::radix_sort(keys, values);
+
+            // values of equal keys stay in input order
+            std::stable_sort(std::begin(expected), std::end(expected), [](auto const& lhs, auto const& rhs) {
+                return lhs.first<rhs.first;
+            });
+            TEST_ASSERT(keys.size()==size && values.size()==size);
+            for (auto n = std::size_t{0}; n!=size; ++n) {
+                TEST_ASSERT(keys[n]==expected[n].first);
+                TEST_ASSERT(values[n]==expected[n].second);
+            }
+        }
+    }
+
+    // check that Transitions which are built by insert and erase, or in bulk,
+    // step through the positions of the edges in order with ending before starting
+    // and rectangles in order of address
+    template<intersections::Axis axis>
+    void test_transitions(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        using Steps = std::vector<std::tuple<int, std::vector<Rectangle const*>, std::vector<Rectangle const*>>>;
+        auto steps = [](intersections::Transitions<axis> const& transitions) {
+            Steps result;
+            for (auto const& step : transitions) {
+                result.emplace_back(
+                        step.position,
+                        std::vector<Rectangle const*>(std::begin(step.ending), std::end(step.ending)),
+                        std::vector<Rectangle const*>(std::begin(step.starting), std::end(step.starting)));
+            }
+            return result;
+        };
+
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            Arena arena;
+            intersections::Transitions<axis> transitions(&arena);
+            std::vector<bool> is_present(rectangles.size(), false);
+            for (auto operation = 0; operation!=num_rectangles*3; ++operation) {
+                auto const index = gen()%rectangles.size();
+                if (is_present[index]) {
+                    transitions.erase(&rectangles[index]);
+                }
+                else {
+                    transitions.insert(&rectangles[index]);
+                }
+                is_present[index] = !is_present[index];
+
+                // rectangles are visited in order of address so each position's edges are already in order
+                std::vector<Rectangle const*> present;
+                std::map<int, std::pair<std::vector<Rectangle const*>, std::vector<Rectangle const*>>> edges;
+                for (auto n = std::size_t{0}; n!=rectangles.size(); ++n) {
+                    if (is_present[n]) {
+                        auto const& interval = rectangles[n].interval(axis);
+                        present.push_back(&rectangles[n]);
+                        edges[interval.end].first.push_back(&rectangles[n]);
+                        edges[interval.start].second.push_back(&rectangles[n]);
+                    }
+                }
+                Steps expected;
+                for (auto const& edge : edges) {
+                    expected.emplace_back(edge.first, edge.second.first, edge.second.second);
+                }
+
+                TEST_ASSERT(transitions.size()==int(present.size()));
+                TEST_ASSERT(steps(transitions)==expected);
+                TEST_ASSERT(steps(intersections::Transitions<axis>(
+                        std::begin(present), std::end(present), &arena))==expected);
+            }
+        }
+    }
+
+    // check set, reset, count and iteration of Bitset and RectangleBitset against std::vector<bool>,
+    // with sizes either side of the boundaries between words
+    void test_bitset(int num_samples)
+    {
+        std::mt19937 gen;
+        for (auto const num_bits : {0, 1, 63, 64, 65, 127, 128, 129, 1000, 10000}) {
+            Arena arena;
+            auto bits = intersections::Bitset(std::size_t(num_bits), &arena);
+            Rectangles rectangles(std::size_t(num_bits), Rectangle{0, 0, 1, 1});
+            auto rectangle_bits = intersections::RectangleBitset(rectangles.data(), rectangles.size(), &arena);
+            std::vector<bool> expected(std::size_t(num_bits), false);
+            TEST_ASSERT(bits.num_words()==std::size_t((num_bits+63)/64));
+
+            // the largest set is left sparse so that iteration skips empty words
+            auto const num_changes = (num_bits>1000) ? 20 : num_samples;
+            for (auto sample = 0; num_bits!=0 && sample!=num_changes; ++sample) {
+                // favour the first and last bits of each word
+                auto index = std::size_t(gen()%num_bits);
+                if (sample%2==0) {
+                    index = std::min(index/64*64+((gen()%2) ? 63 : 0), std::size_t(num_bits-1));
+                }
+
+                auto const rectangle = rectangles.data()+index;
+                if (gen()%3!=0) {
+                    TEST_ASSERT(bits.set(index)==!expected[index]);
+                    TEST_ASSERT(rectangle_bits.insert(rectangle)==!expected[index]);
+                    expected[index] = true;
+                }
+                else {
+                    TEST_ASSERT(bits.reset(index)==expected[index]);
+                    TEST_ASSERT(rectangle_bits.erase(rectangle)==expected[index]);
+                    expected[index] = false;
+                }
+                TEST_ASSERT(bits.test(index)==expected[index]);
+                TEST_ASSERT(rectangle_bits.contains(rectangle)==expected[index]);
+            }
+
+            std::vector<std::size_t> expected_indices;
+            std::vector<Rectangle const*> expected_rectangles;
+            for (auto index = std::size_t{0}; index!=expected.size(); ++index) {
+                if (expected[index]) {
+                    expected_indices.push_back(index);
+                    expected_rectangles.push_back(rectangles.data()+index);
+                }
+            }
+            TEST_ASSERT(bits.count()==int(expected_indices.size()));
+            TEST_ASSERT(rectangle_bits.size()==int(expected_indices.size()));
+            TEST_ASSERT(std::vector<std::size_t>(std::begin(bits), std::end(bits))==expected_indices);
+            TEST_ASSERT(std::vector<Rectangle const*>(std::begin(rectangle_bits), std::end(rectangle_bits))
+                        ==expected_rectangles);
+
+            auto const copy = bits;
+            TEST_ASSERT(copy==bits);
+            bits.clear();
+            TEST_ASSERT(bits.count()==0);
+            TEST_ASSERT(std::begin(bits)==std::end(bits));
+            TEST_ASSERT((copy!=bits)==!expected_indices.empty());
+        }
+    }
+
+    // check that an exception thrown by a task of parallel_for is rethrown by the calling thread
+    void test_parallel_for(int num_tasks, int num_threads)
+    {
+        auto is_caught = false;
+        try {
+            intersections::parallel_for(num_tasks, num_threads, [num_tasks](int const n) {
+                if (n==num_tasks-1) {
+                    throw std::runtime_error("task failed");
+                }
+            });
+        }
+        catch (std::runtime_error const&) {
+            is_caught = true;
+        }
+        TEST_ASSERT(is_caught);
+    }
+
+    // check that parallel_for_ordered reports every result in order, holds no more than max_pending,
+    // stops when report returns false and rethrows an exception thrown by a task or by report
+    void test_parallel_for_ordered(int num_tasks, int num_threads, int max_pending)
+    {
+        std::atomic<int> num_started(0);
+        std::atomic<int> num_reported(0);
+        auto max_held = 0;
+        auto const task = [&](int const n) {
+            ++num_started;
+            return std::vector<int>(std::size_t(n%7), n);
+        };
+
+        std::vector<int> reported;
+        intersections::parallel_for_ordered(num_tasks, num_threads, max_pending, task,
+                [&](int const n, std::vector<int> const& result) {
+                    TEST_ASSERT(result==std::vector<int>(std::size_t(n%7), n));
+                    max_held = std::max(max_held, num_started-num_reported);
+                    ++num_reported;
+                    reported.push_back(n);
+                    return true;
+                });
+        auto expected = std::vector<int>(std::size_t(num_tasks));
+        std::iota(std::begin(expected), std::end(expected), 0);
+        TEST_ASSERT(reported==expected);
+        TEST_ASSERT(max_held<=max_pending);
+
+        // no task is started more than max_pending beyond the last reported
+        num_started = 0;
+        reported.clear();
+        auto const last = num_tasks/2;
+        intersections::parallel_for_ordered(num_tasks, num_threads, max_pending, task,
+                [&](int const n, std::vector<int> const&) {
+                    reported.push_back(n);
+                    return n!=last;
+                });
+        TEST_ASSERT(int(reported.size())==last+1);
+        TEST_ASSERT(num_started<=last+1+max_pending);
+
+        for (auto const is_task_failing : {true, false}) {
+            auto is_caught = false;
+            try {
+                intersections::parallel_for_ordered(num_tasks, num_threads, max_pending,
+                        [&](int const n) {
+                            if (is_task_failing && n==last) {
+                                throw std::runtime_error("task failed");
+                            }
+                            return n;
+                        },
+                        [&](int const n, int) {
+                            if (!is_task_failing && n==last) {
+                                throw std::runtime_error("report failed");
+                            }
+                            return true;
+                        });
+            }
+            catch (std::runtime_error const&) {
+                is_caught = true;
+            }
+            TEST_ASSERT(is_caught);
+        }
+    }
+
+    // check that limits in SolveOptions match filtering the unlimited results
+    template<Solution solution>
+    void test_options(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        using Visits = std::vector<std::pair<Rectangle, RectangleSequence>>;
+        auto record = [](Visits& visits) {
+            return [&visits](Rectangle const& overlap, RectangleSequence const& constituents) {
+                visits.emplace_back(overlap, constituents);
+            };
+        };
+
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            auto options = SolveOptions{};
+            options.min_constituents = std::size_t(2+sample%4);
+            options.min_area = sample%3*20;
+
+            // the limited results are the unlimited results which are within the limits
+            auto const all = solve<solution>(rectangles);
+            auto const limited = solve<solution>(rectangles, options);
+            auto expected = Intersections{};
+            for (auto const& intersection : all) {
+                if (intersection.second.size()>=options.min_constituents
+                        && intersection.first.area()>=options.min_area) {
+                    expected.emplace(intersection.first, intersection.second);
+                }
+            }
+            TEST_ASSERT(limited==expected);
+
+            // and the search stops after max_results
+            Visits visits;
+            solve<solution>(rectangles, record(visits), options);
+            options.max_results = visits.size()/2;
+            Visits first_visits;
+            solve<solution>(rectangles, record(first_visits), options);
+            TEST_ASSERT(first_visits.size()==options.max_results);
+            TEST_ASSERT(std::equal(std::begin(first_visits), std::end(first_visits), std::begin(visits)));
+        }
+    }
+
+    // check that recording stats does not change the results and that they count what they say
     template<Solution solution>
-    void generate_data(int max_rectangles_bits)
+    void test_stats(int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        Rectangles rectangles;
+        std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+            return random(gen, max_rectangle);
+        });
+
+        auto stats = SolveStats{};
+        auto options = SolveOptions{};
+        options.stats = &stats;
+        auto const results = solve<solution>(rectangles, options);
+        TEST_ASSERT(results==solve<solution>(rectangles));
+
+#if defined(INTERSECTIONS_STATS)
+        // each result is looked up once as it is added to the map
+        TEST_ASSERT(stats.counts.hash_probes==results.size());
+        TEST_ASSERT(stats.counts.bytes_allocated>0);
+        TEST_ASSERT(stats.build_seconds+stats.sweep_seconds>0);
+
+        // every range of the fast sweep is either reported or discarded
+        if (solution==Solution::fast || solution==Solution::fast_parallel) {
+            TEST_ASSERT(stats.counts.sweep_callbacks==results.size()+stats.counts.duplicates_discarded);
+        }
+        if (solution==Solution::simple || solution==Solution::cliques) {
+            TEST_ASSERT(stats.counts.recursion_nodes>=results.size());
+        }
+
+        // and a second call adds to the first
+        auto const first_stats = stats;
+        solve<solution>(rectangles, options);
+        TEST_ASSERT(stats.counts.hash_probes==first_stats.counts.hash_probes*2);
+#else
+        TEST_ASSERT(stats.counts.hash_probes==0);
+#endif
+    }
+
+    // check that each supported kernel agrees with scalar overlap tests
+    void test_rectangle_batch(int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        Rectangles rectangles;
+        std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+            return random(gen, max_rectangle);
+        });
+
+        auto const batch = RectangleBatch(rectangles);
+        TEST_ASSERT(batch.size()==rectangles.size());
+        TEST_ASSERT(batch.num_words()==(rectangles.size()+63)/64);
+        TEST_ASSERT(reinterpret_cast<std::uintptr_t>(batch.x0())%RectangleBatch::alignment==0);
+
+        for (auto isa : {Isa::scalar, Isa::sse2, Isa::avx2}) {
+            if (!intersections::is_supported(isa)) {
+                continue;
+            }
+
+            auto const matrix = intersections::overlap_matrix(batch, isa);
+            for (auto n = std::size_t{0}; n!=rectangles.size(); ++n) {
+                TEST_ASSERT(batch[n]==rectangles[n]);
+                for (auto m = std::size_t{0}; m!=rectangles.size(); ++m) {
+                    auto const bit = (matrix[n*batch.num_words()+m/64] >> (m%64)) & 1;
+                    auto const expected = n!=m && is_positive(rectangles[n] & rectangles[m]);
+                    TEST_ASSERT(bit==expected);
+                }
+            }
+        }
+    }
+
+    // check overlapping_pairs against a brute-force search
+    void test_pairs(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            auto const graph = intersections::overlapping_pairs(rectangles);
+            TEST_ASSERT(graph.num_vertices()==rectangles.size());
+
+            auto num_edges = std::size_t{0};
+            for (auto n = std::size_t{0}; n!=rectangles.size(); ++n) {
+                std::vector<intersections::OverlapGraph::Index> expected;
+                for (auto m = std::size_t{0}; m!=rectangles.size(); ++m) {
+                    if (n!=m && is_positive(rectangles[n] & rectangles[m])) {
+                        expected.push_back(intersections::OverlapGraph::Index(m));
+                    }
+                }
+
+                auto const neighbors = graph.neighbors(n);
+                TEST_ASSERT(std::equal(
+                        std::begin(neighbors), std::end(neighbors), std::begin(expected), std::end(expected)));
+                num_edges += expected.size();
+            }
+            TEST_ASSERT(graph.num_edges()*2==num_edges);
+        }
+    }
+
+    // check max_depth against the results of solve and a brute-force count of depth
+    void test_max_depth(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            intersections::AreaByDepth area_by_depth;
+            auto const actual = intersections::max_depth(rectangles, area_by_depth);
+            TEST_ASSERT(actual.depth==intersections::max_depth(rectangles).depth);
+
+            // the witness is one of the results of solve
+            auto const intersections = solve<Solution::fast>(rectangles);
+            auto expected_depth = std::min(num_rectangles, 1);
+            for (auto const& intersection : intersections) {
+                expected_depth = std::max(expected_depth, int(intersection.second.size()));
+            }
+            TEST_ASSERT(actual.depth==expected_depth);
+            TEST_ASSERT(int(actual.constituents.size())==actual.depth);
+            if (actual.depth>=2) {
+                auto const found = intersections.find(actual.region);
+                TEST_ASSERT(found!=std::end(intersections) && found->second==actual.constituents);
+            }
+
+            // count the depth of each unit square within the bounds of the rectangles
+            auto bounds = std::array<Interval, 2>{{rectangles.front().interval(intersections::Axis::horizontal),
+                                                   rectangles.front().interval(intersections::Axis::vertical)}};
+            for (auto const& rectangle : rectangles) {
+                for (auto axis : {intersections::Axis::horizontal, intersections::Axis::vertical}) {
+                    auto& bound = bounds[int(axis)];
+                    bound.start = std::min(bound.start, rectangle.interval(axis).start);
+                    bound.end = std::max(bound.end, rectangle.interval(axis).end);
+                }
+            }
+            intersections::AreaByDepth expected_area_by_depth(actual.depth+1);
+            for (auto x = bounds[0].start; x!=bounds[0].end; ++x) {
+                for (auto y = bounds[1].start; y!=bounds[1].end; ++y) {
+                    auto const depth = std::count_if(
+                            std::begin(rectangles), std::end(rectangles), [x, y](Rectangle const& rectangle) {
+                                return contains(rectangle, Rectangle{x, y, 1, 1});
+                            });
+                    ++expected_area_by_depth[depth];
+                }
+            }
+            TEST_ASSERT(area_by_depth==expected_area_by_depth);
+
+            // the area covered to at least each depth is the sum of the areas at greater depths
+            auto at_least = std::int64_t{0};
+            for (auto depth = actual.depth+1; depth>1; --depth) {
+                TEST_ASSERT(intersections::coverage_area(rectangles, depth)==at_least);
+                at_least += area_by_depth[depth-1];
+            }
+            TEST_ASSERT(intersections::union_area(rectangles)==at_least);
+        }
+    }
+
+    // returns the area within the bounds of the rectangles which is covered by exactly each depth,
+    // counted unit square by unit square using sums of differences at the corners of the rectangles;
+    // the bounds must be small enough to count
+    intersections::AreaByDepth count_area_by_depth(Rectangles const& rectangles)
+    {
+        using intersections::Axis;
+        auto x = rectangles.front().interval(Axis::horizontal);
+        auto y = rectangles.front().interval(Axis::vertical);
+        for (auto const& rectangle : rectangles) {
+            x = Interval{std::min(x.start, rectangle.interval(Axis::horizontal).start),
+                         std::max(x.end, rectangle.interval(Axis::horizontal).end)};
+            y = Interval{std::min(y.start, rectangle.interval(Axis::vertical).start),
+                         std::max(y.end, rectangle.interval(Axis::vertical).end)};
+        }
+
+        auto const width = std::size_t(x.end-x.start)+1;
+        auto const height = std::size_t(y.end-y.start)+1;
+        std::vector<int> depths(width*height, 0);
+        auto const corner = [&](int const corner_x, int const corner_y) -> int& {
+            return depths[std::size_t(corner_y-y.start)*width+std::size_t(corner_x-x.start)];
+        };
+        for (auto const& rectangle : rectangles) {
+            auto const& horizontal = rectangle.interval(Axis::horizontal);
+            auto const& vertical = rectangle.interval(Axis::vertical);
+            ++corner(horizontal.start, vertical.start);
+            --corner(horizontal.end, vertical.start);
+            --corner(horizontal.start, vertical.end);
+            ++corner(horizontal.end, vertical.end);
+        }
+
+        intersections::AreaByDepth area_by_depth(1, 0);
+        for (auto row = std::size_t{0}; row!=height-1; ++row) {
+            for (auto column = std::size_t{0}; column!=width-1; ++column) {
+                auto& depth = depths[row*width+column];
+                depth += ((column!=0) ? depths[row*width+column-1] : 0)
+                         +((row!=0) ? depths[(row-1)*width+column] : 0)
+                         -((row!=0 && column!=0) ? depths[(row-1)*width+column-1] : 0);
+                if (std::size_t(depth)>=area_by_depth.size()) {
+                    area_by_depth.resize(std::size_t(depth)+1, 0);
+                }
+                ++area_by_depth[std::size_t(depth)];
+            }
+        }
+        return area_by_depth;
+    }
+
+    // check the area by depth of max_depth against counting unit squares
+    // for thousands of rectangles, some long and thin so that there are many runs of uniform depth
+    void test_area_by_depth(int num_samples, int num_rectangles, int extent)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                auto rectangle = random(gen, Rectangle{-extent/2, -extent/2, extent, extent});
+                switch (gen()%4) {
+                    case 0:
+                        return Rectangle{rectangle.x(), rectangle.y(), rectangle.w(), 1+rectangle.h()%3};
+                    case 1:
+                        return Rectangle{rectangle.x(), rectangle.y(), 1+rectangle.w()%3, rectangle.h()};
+                    default:
+                        return rectangle;
+                }
+            });
+
+            intersections::AreaByDepth area_by_depth;
+            auto const actual = intersections::max_depth(rectangles, area_by_depth);
+            auto const expected = count_area_by_depth(rectangles);
+            TEST_ASSERT(area_by_depth==expected);
+            TEST_ASSERT(actual.depth==int(expected.size())-1);
+        }
+    }
+
+    void test_coverage_area()
+    {
+        TEST_ASSERT(intersections::union_area(Rectangles{})==0);
+
+        // areas which do not fit in an int
+        auto rectangles = Rectangles{
+                Rectangle {0, 0, 60000, 60000},
+                Rectangle {30000, 30000, 60000, 60000},
+                Rectangle {-60000, 0, 60000, 60000}};
+        TEST_ASSERT(intersections::union_area(rectangles)==std::int64_t{60000}*60000*3-std::int64_t{30000}*30000);
+        TEST_ASSERT(intersections::coverage_area(rectangles, 2)==std::int64_t{30000}*30000);
+        TEST_ASSERT(intersections::coverage_area(rectangles, 3)==0);
+    }
+
+    // check union_area and coverage_area against counting unit squares for thousands of rectangles
+    // with enough distinct vertical coordinates to be split into strips, and some tall enough to span them
+    void test_coverage_random(int num_samples, int num_rectangles, int width, int height)
+    {
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                auto const rectangle = random(gen, Rectangle{-width/2, -height/2, width, height});
+                return (sample%3!=0 && gen()%4!=0)
+                       ? Rectangle{rectangle.x(), rectangle.y(), rectangle.w(), 1+rectangle.h()%50}
+                       : rectangle;
+            });
+
+            // the area covered to at least each depth is the sum of the areas at that depth and above
+            auto const area_by_depth = count_area_by_depth(rectangles);
+            auto const max_depth = int(area_by_depth.size())-1;
+            std::vector<std::int64_t> at_least(area_by_depth.size()+1, 0);
+            for (auto depth = max_depth; depth>=0; --depth) {
+                at_least[std::size_t(depth)] = at_least[std::size_t(depth)+1]+area_by_depth[std::size_t(depth)];
+            }
+            TEST_ASSERT(intersections::union_area(rectangles)==at_least[1]);
+            for (auto const depth : {1, 2, 3, 5, 8}) {
+                auto const expected = (depth<=max_depth) ? at_least[std::size_t(depth)] : 0;
+                TEST_ASSERT(intersections::coverage_area(rectangles, depth)==expected);
+            }
+        }
+    }
+
+    // check that an IncrementalSolver agrees with solving its rectangles from scratch after each change
+    // and that its deltas describe the changes to its results
+    void test_incremental(int num_changes, int num_rectangles, Rectangle max_rectangle)
+    {
+        using intersections::IncrementalSolver;
+        std::mt19937 gen;
+        Rectangles initial_rectangles;
+        std::generate_n(std::back_inserter(initial_rectangles), num_rectangles, [&]() {
+            return random(gen, max_rectangle);
+        });
+
+        IncrementalSolver solver(initial_rectangles);
+        auto results = solver.results();
+        std::vector<IncrementalSolver::Id> ids(initial_rectangles.size());
+        std::iota(std::begin(ids), std::end(ids), IncrementalSolver::Id{0});
+        for (auto change = 0; change!=num_changes; ++change) {
+            // insert, erase or move a rectangle
+            IncrementalSolver::Delta delta;
+            auto const index = std::uniform_int_distribution<std::size_t>(0, ids.size()-1)(gen);
+            switch (change%3) {
+                case 0:
+                    ids.push_back(solver.insert(random(gen, max_rectangle), delta));
+                    break;
+                case 1:
+                    solver.erase(ids[index], delta);
+                    ids.erase(std::begin(ids)+index);
+                    break;
+                default:
+                    solver.move(ids[index], random(gen, max_rectangle), delta);
+                    break;
+            }
+
+            // apply the delta to the previous results
+            for (auto const& removed : delta.removed) {
+                TEST_ASSERT(results.erase(removed.first)==1);
+            }
+            for (auto const& added : delta.added) {
+                TEST_ASSERT(results.emplace(added.first, added.second).second);
+            }
+            TEST_ASSERT(results==solver.results());
+
+            // and compare with the results of solving every rectangle in order of Id.
+            std::sort(std::begin(ids), std::end(ids));
+            Rectangles rectangles;
+            for (auto const id : ids) {
+                rectangles.push_back(solver.rectangle(id));
+            }
+            TEST_ASSERT(solver.size()==rectangles.size());
+
+            auto expected = IncrementalSolver::Results{};
+            for (auto const& intersection : solve<Solution::fast>(rectangles)) {
+                IncrementalSolver::Constituents constituents;
+                for (auto const constituent : intersection.second) {
+                    constituents.push_back(ids[constituent-rectangles.data()]);
+                }
+                expected.emplace(intersection.first, constituents);
+            }
+            TEST_ASSERT(solver.results()==expected);
+        }
+    }
+
+    // check the queries of RTree against linear scans
+    void test_rtree(int num_samples, int num_rectangles, Rectangle max_rectangle)
+    {
+        using intersections::Point;
+        using intersections::RTree;
+        using Indices = std::vector<RTree::Index>;
+        std::mt19937 gen;
+        std::uniform_int_distribution<int> x_distribution(
+                max_rectangle.interval(intersections::Axis::horizontal).start-10,
+                max_rectangle.interval(intersections::Axis::horizontal).end+10);
+        std::uniform_int_distribution<int> y_distribution(
+                max_rectangle.interval(intersections::Axis::vertical).start-10,
+                max_rectangle.interval(intersections::Axis::vertical).end+10);
+        auto const random_point = [&]() {
+            return Point{x_distribution(gen), y_distribution(gen)};
+        };
+
+        TEST_ASSERT(RTree(Rectangles{}).containing(Point{0, 0}).empty());
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles*sample/num_samples, [&]() {
+                return random(gen, max_rectangle);
+            });
+            auto const tree = RTree(rectangles);
+            TEST_ASSERT(tree.size()==rectangles.size());
+
+            std::vector<Point> points;
+            Rectangles windows;
+            for (auto query = 0; query!=20; ++query) {
+                points.push_back(random_point());
+                windows.push_back(random(gen, max_rectangle));
+            }
+            auto const batch_containing = tree.containing(points);
+            auto const batch_overlapping = tree.overlapping(windows);
+            TEST_ASSERT(batch_containing.size()==points.size());
+            TEST_ASSERT(batch_overlapping.size()==windows.size());
+
+            for (auto query = std::size_t{0}; query!=points.size(); ++query) {
+                auto const point = points[query];
+                auto const& window = windows[query];
+                Indices expected_containing, expected_overlapping, by_distance(rectangles.size());
+                for (auto n = std::size_t{0}; n!=rectangles.size(); ++n) {
+                    if (contains(rectangles[n], point.x, point.y)) {
+                        expected_containing.push_back(RTree::Index(n));
+                    }
+                    if (is_positive(rectangles[n] & window)) {
+                        expected_overlapping.push_back(RTree::Index(n));
+                    }
+                }
+
+                TEST_ASSERT(tree.containing(point)==expected_containing);
+                auto const containing = batch_containing.matches(query);
+                TEST_ASSERT(Indices(std::begin(containing), std::end(containing))==expected_containing);
+
+                TEST_ASSERT(tree.overlapping(window)==expected_overlapping);
+                auto const overlapping = batch_overlapping.matches(query);
+                TEST_ASSERT(Indices(std::begin(overlapping), std::end(overlapping))==expected_overlapping);
+
+                // the nearest rectangles are ordered by distance to the point and then by index
+                auto const squared_distance = [point](Rectangle const& rectangle) {
+                    auto const distance = [](int const position, Interval const& interval) {
+                        return std::max({std::int64_t(interval.start)-position,
+                                         std::int64_t(position)-interval.end, std::int64_t{0}});
+                    };
+                    auto const dx = distance(point.x, rectangle.interval(intersections::Axis::horizontal));
+                    auto const dy = distance(point.y, rectangle.interval(intersections::Axis::vertical));
+                    return dx*dx+dy*dy;
+                };
+                std::iota(std::begin(by_distance), std::end(by_distance), RTree::Index{0});
+                std::stable_sort(std::begin(by_distance), std::end(by_distance), [&](auto lhs, auto rhs) {
+                    return squared_distance(rectangles[lhs])<squared_distance(rectangles[rhs]);
+                });
+                auto const k = std::min(std::size_t(query), rectangles.size());
+                TEST_ASSERT(tree.nearest(point, query)==Indices(std::begin(by_distance), std::begin(by_distance)+k));
+            }
+        }
+    }
+
+    // check that the automatic solution agrees with the fast solution
+    // and that a cost model can be fitted, saved and loaded
+    void test_automatic(int num_samples, int num_rectangles)
     {
-        for (auto e = 0; e<=max_rectangles_bits; ++e) {
-            for (auto f = 2; f<=3; ++f) {
-                auto n = f << e;
-                std::printf("%d rectangles ... ", n);
-                test_heavy_for_speed<solution>(1, Interval{n, n}, Interval{250, 250});
+        using intersections::CostModel;
+        using intersections::Workload;
+
+        std::mt19937 gen;
+        for (auto sample = 0; sample!=num_samples; ++sample) {
+            auto const max_rectangle = Rectangle{0, 0, 10+sample*sample, 10+sample*sample};
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+            TEST_ASSERT(solve<Solution::automatic>(rectangles)==solve<Solution::fast>(rectangles));
+        }
+
+        for (auto n = 0; n!=int(intersections::num_engines)+1; ++n) {
+            auto solution = Solution::fast;
+            TEST_ASSERT(intersections::from_string(intersections::to_string(Solution(n)), solution));
+            TEST_ASSERT(solution==Solution(n));
+        }
+
+        // a model fitted to the predictions of a model for a machine a thousand times slower
+        // predicts the same relative times
+        auto const model = CostModel{};
+        auto const slowdown = 1000.;
+        std::vector<CostModel::Sample> samples;
+        std::vector<Workload> workloads;
+        for (auto num_rectangles : {10, 100, 1000, 10000}) {
+            for (auto mean_degree : {0., 1., 10., 100.}) {
+                for (auto grid_bytes : {1000, 1000000, 1000000000}) {
+                    auto const workload = Workload{std::size_t(num_rectangles), mean_degree, std::size_t(grid_bytes)};
+                    workloads.push_back(workload);
+                    for (auto n = std::size_t{0}; n!=intersections::num_engines; ++n) {
+                        samples.push_back(
+                                CostModel::Sample{Solution(n), workload, model.predict(Solution(n), workload)*slowdown});
+                    }
+                }
             }
         }
+        auto fitted = CostModel{};
+        fitted.fit(samples);
+        for (auto const& sample : samples) {
+            auto const seconds = fitted.predict(sample.solution, sample.workload);
+            TEST_ASSERT(std::abs(std::log(seconds/sample.seconds))<.01);
+        }
+        for (auto const& workload : workloads) {
+            TEST_ASSERT(fitted.choose(workload)==model.choose(workload));
+        }
+
+        // and a saved model loads unchanged.
+        auto const filename = "test_cost_model.txt";
+        TEST_ASSERT(fitted.save(filename));
+        auto loaded = CostModel{};
+        TEST_ASSERT(loaded.load(filename));
+        std::remove(filename);
+        for (auto n = std::size_t{0}; n!=intersections::num_engines; ++n) {
+            TEST_ASSERT(loaded.coefficients(Solution(n))==fitted.coefficients(Solution(n)));
+        }
+        for (auto const& workload : workloads) {
+            TEST_ASSERT(loaded.choose(workload)==fitted.choose(workload));
+        }
+        TEST_ASSERT(!loaded.load("missing_cost_model.txt"));
+    }
+
+    // check that the grid solution rejects rectangles whose grid exceeds its memory budget
+    void test_grid_budget(int num_rectangles)
+    {
+        // each rectangle adds two rows and two columns
+        Rectangles rectangles;
+        for (auto n = 0; n!=num_rectangles; ++n) {
+            rectangles.push_back(Rectangle{n, n, num_rectangles*2, num_rectangles*2});
+        }
+        TEST_ASSERT(!intersections::grid_fits(rectangles));
+
+        auto is_rejected = false;
+        try {
+            solve<Solution::grid>(rectangles);
+        }
+        catch (std::length_error const&) {
+            is_rejected = true;
+        }
+        TEST_ASSERT(is_rejected);
+
+        rectangles.resize(std::size_t(num_rectangles/100));
+        TEST_ASSERT(intersections::grid_fits(rectangles));
+        TEST_ASSERT(solve<Solution::grid>(rectangles)==solve<Solution::fast>(rectangles));
     }
 
+    // check that solve<Solution::cliques> rejects rectangles whose overlap matrix exceeds its budget
+    void test_cliques_budget(int num_rectangles)
+    {
+        // a diagonal chain in which each rectangle overlaps the next
+        Rectangles rectangles;
+        for (auto n = 0; n!=num_rectangles; ++n) {
+            rectangles.push_back(Rectangle{n, n, 2, 2});
+        }
+        TEST_ASSERT(!intersections::cliques_fit(rectangles));
+
+        auto is_rejected = false;
+        try {
+            solve<Solution::cliques>(rectangles);
+        }
+        catch (std::length_error const&) {
+            is_rejected = true;
+        }
+        TEST_ASSERT(is_rejected);
+
+        rectangles.resize(std::size_t(num_rectangles/100));
+        TEST_ASSERT(intersections::cliques_fit(rectangles));
+        TEST_ASSERT(solve<Solution::cliques>(rectangles)==solve<Solution::fast>(rectangles));
+    }
+
+    // check that rectangles saved to a binary file are read back unchanged
+    void test_rectangle_file(int num_rectangles)
+    {
+        std::mt19937 gen;
+        for (auto const max_rectangle : {Rectangle{-1000, -1000, 2000, 2000}, Rectangle{-100000, 0, 300000, 70000}}) {
+            Rectangles rectangles;
+            std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+                return random(gen, max_rectangle);
+            });
+
+            auto const filename = "test_rectangles.rects";
+            TEST_ASSERT(intersections::save_rectangle_file(filename, rectangles));
+            TEST_ASSERT(intersections::is_rectangle_file(filename));
+
+            intersections::RectangleFile file;
+            TEST_ASSERT(file.open(filename));
+            TEST_ASSERT(file.coordinate_width()==((max_rectangle.w()<=32767) ? 2 : 4));
+            TEST_ASSERT(file.size()==rectangles.size());
+            TEST_ASSERT(file[0]==rectangles[0]);
+            TEST_ASSERT(file.rectangles()==rectangles);
+            file.close();
+            TEST_ASSERT(file.empty());
+            std::remove(filename);
+        }
+
+        // A file which is not a rectangle file is rejected.
+        auto const filename = "test_not_rectangles.rects";
+        auto const file = std::fopen(filename, "wb");
+        std::fputs("RECT but not really", file);
+        std::fclose(file);
+        intersections::RectangleFile rectangle_file;
+        TEST_ASSERT(!rectangle_file.open(filename));
+        TEST_ASSERT(!rectangle_file.open("missing_rectangles.rects"));
+        TEST_ASSERT(!intersections::is_rectangle_file("missing_rectangles.rects"));
+        std::remove(filename);
+
+        // Nor is one with a rectangle which is empty or extends beyond the largest int.
+        auto const overwrite = [](char const* const filename, long const offset, int const width, int const value) {
+            unsigned char bytes[4];
+            for (auto byte = 0; byte!=width; ++byte) {
+                bytes[byte] = static_cast<unsigned char>(std::uint32_t(value) >> (byte*8));
+            }
+            auto const file = std::fopen(filename, "r+b");
+            TEST_ASSERT(file!=nullptr);
+            TEST_ASSERT(std::fseek(file, offset, SEEK_SET)==0);
+            TEST_ASSERT(std::fwrite(bytes, 1, std::size_t(width), file)==std::size_t(width));
+            std::fclose(file);
+        };
+        struct Patch {
+            int width;
+            int array;
+            int value;
+        };
+        auto const max_int = std::numeric_limits<int>::max();
+        for (auto const patch : {Patch{4, 2, 0}, Patch{4, 3, -1}, Patch{4, 0, max_int}, Patch{4, 1, max_int},
+                                 Patch{2, 2, -2}, Patch{2, 3, 0}}) {
+            // the second rectangle is wide enough to need 4-byte coordinates, or not
+            auto const rectangles = Rectangles{Rectangle{0, 0, 1, 1}, Rectangle{0, 0, (patch.width==4) ? 40000 : 2, 1}};
+            auto const invalid_filename = "test_invalid_rectangles.rects";
+            TEST_ASSERT(intersections::save_rectangle_file(invalid_filename, rectangles));
+            TEST_ASSERT(rectangle_file.open(invalid_filename));
+            TEST_ASSERT(rectangle_file.coordinate_width()==patch.width);
+            rectangle_file.close();
+
+            auto const offset = long(intersections::RectangleFile::header_size)+(patch.array*2+1)*patch.width;
+            overwrite(invalid_filename, offset, patch.width, patch.value);
+            TEST_ASSERT(!rectangle_file.open(invalid_filename));
+            TEST_ASSERT(rectangle_file.empty());
+            std::remove(invalid_filename);
+        }
+    }
+
+    // check that RectanglesHandler reads rectangles, skips unknown members however deeply they nest
+    // and rejects documents of any other form, given the events which a SAX parser sends for them
+    void test_rectangles_handler()
+    {
+        using intersections::RectanglesHandler;
+        auto const key = [](RectanglesHandler& handler, char const* const name) {
+            return handler.Key(name, RectanglesHandler::SizeType(std::strlen(name)), true);
+        };
+
+        // {"x": x, "y": 2, "w": 3, "h": 4}
+        auto const rect = [&key](RectanglesHandler& handler, int const x) {
+            return handler.StartObject() && key(handler, "x") && handler.Int(x) && key(handler, "y")
+                   && handler.Uint(2) && key(handler, "w") && handler.Int(3) && key(handler, "h") && handler.Int(4)
+                   && handler.EndObject(4);
+        };
+
+        // {"name": "a", "rects": [rect, {"meta": {"a": [1, {"b": null}], "c": 1.5}, rect fields}], "more": [[1]]}
+        Rectangles rectangles;
+        RectanglesHandler handler(rectangles);
+        TEST_ASSERT(handler.StartObject() && key(handler, "name") && handler.String("a", 1, true)
+                    && key(handler, "rects") && handler.StartArray() && rect(handler, 1)
+                    && handler.StartObject() && key(handler, "meta") && handler.StartObject() && key(handler, "a")
+                    && handler.StartArray() && handler.Int(1) && handler.StartObject() && key(handler, "b")
+                    && handler.Null() && handler.EndObject(1) && handler.EndArray(2) && key(handler, "c")
+                    && handler.Double(1.5) && handler.EndObject(2) && key(handler, "x") && handler.Int(-5)
+                    && key(handler, "y") && handler.Int(2) && key(handler, "w") && handler.Int(3)
+                    && key(handler, "h") && handler.Int(4) && handler.EndObject(5) && handler.EndArray(2)
+                    && key(handler, "more") && handler.StartArray() && handler.StartArray() && handler.Uint(1)
+                    && handler.EndArray(1) && handler.EndArray(1) && handler.EndObject(3));
+        TEST_ASSERT(handler.has_rects());
+        TEST_ASSERT((rectangles==Rectangles{Rectangle{1, 2, 3, 4}, Rectangle{-5, 2, 3, 4}}));
+
+        // a rectangle which is missing a field is rejected
+        rectangles.clear();
+        RectanglesHandler missing_field(rectangles);
+        TEST_ASSERT(missing_field.StartObject() && key(missing_field, "rects") && missing_field.StartArray()
+                    && missing_field.StartObject() && key(missing_field, "x") && missing_field.Int(1)
+                    && key(missing_field, "y") && missing_field.Int(2) && key(missing_field, "w")
+                    && missing_field.Int(3));
+        TEST_ASSERT(!missing_field.EndObject(3));
+
+        // as is a coordinate which is not an int
+        auto const is_coordinate_accepted = [&key, &rectangles](auto const& send_coordinate) {
+            RectanglesHandler coordinate_handler(rectangles);
+            TEST_ASSERT(coordinate_handler.StartObject() && key(coordinate_handler, "rects")
+                        && coordinate_handler.StartArray() && coordinate_handler.StartObject()
+                        && key(coordinate_handler, "w"));
+            return send_coordinate(coordinate_handler);
+        };
+        TEST_ASSERT(is_coordinate_accepted([](RectanglesHandler& h) { return h.Int(1); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.Double(1.5); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.String("1", 1, true); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.Uint(3000000000u); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.Int64(std::int64_t{1} << 40); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.Null(); }));
+        TEST_ASSERT(!is_coordinate_accepted([](RectanglesHandler& h) { return h.StartArray(); }));
+
+        // as is a value of "rects" which is not an array
+        RectanglesHandler rects_object(rectangles);
+        TEST_ASSERT(rects_object.StartObject() && key(rects_object, "rects"));
+        TEST_ASSERT(!rects_object.StartObject());
+        RectanglesHandler rects_number(rectangles);
+        TEST_ASSERT(rects_number.StartObject() && key(rects_number, "rects"));
+        TEST_ASSERT(!rects_number.Int(1));
+
+        // while a document without "rects" parses but has no rectangles, which the command line treats as an error
+        rectangles.clear();
+        RectanglesHandler no_rects(rectangles);
+        TEST_ASSERT(no_rects.StartObject() && key(no_rects, "rect") && no_rects.StartArray() && no_rects.EndArray(0)
+                    && no_rects.EndObject(1));
+        TEST_ASSERT(!no_rects.has_rects());
+        TEST_ASSERT(rectangles.empty());
+    }
+
+    // reports every overlap twice
+    void solve_twice(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        solve<Solution::fast>(rectangles, visitor, options, arena);
+        solve<Solution::fast>(rectangles, visitor, options, arena);
+    }
+
+    // check that sorted results are the same whether they fit in memory or are spilled to disk
+    void test_spill(int num_rectangles, Rectangle max_rectangle)
+    {
+        std::mt19937 gen;
+        Rectangles rectangles;
+        std::generate_n(std::back_inserter(rectangles), num_rectangles, [&]() {
+            return random(gen, max_rectangle);
+        });
+
+        // the results of fast, in order of overlap
+        using Visits = std::vector<std::pair<Rectangle, RectangleSequence>>;
+        auto const all = solve<Solution::fast>(rectangles);
+        auto expected = Visits(std::begin(all), std::end(all));
+        std::sort(std::begin(expected), std::end(expected), [](auto const& lhs, auto const& rhs) {
+            return lhs.first<rhs.first;
+        });
+        TEST_ASSERT(expected.size()>1000);
+
+        auto record = [](Visits& visits) {
+            return [&visits](Rectangle const& overlap, RectangleSequence const& constituents) {
+                visits.emplace_back(overlap, constituents);
+            };
+        };
+
+        // within the budget,
+        Visits in_memory;
+        solve_sorted<Solution::fast>(rectangles, record(in_memory), SpillOptions{});
+        TEST_ASSERT(in_memory==expected);
+
+        // spilled to many runs in the temporary directory which must be merged in more than one pass,
+        Visits spilled;
+        auto spill = SpillOptions{};
+        spill.memory_budget = 256;
+        solve_sorted<Solution::fast>(rectangles, record(spilled), spill);
+        TEST_ASSERT(spilled==expected);
+
+        // spilled to a given directory
+        Visits in_directory;
+        spill.directory = ".";
+        solve_sorted<Solution::fast>(rectangles, record(in_directory), spill);
+        TEST_ASSERT(in_directory==expected);
+
+        // and with duplicates removed.
+        Visits deduplicated;
+        spill.memory_budget = 4096;
+        intersections::solve_sorted(rectangles, record(deduplicated), solve_twice, spill);
+        TEST_ASSERT(deduplicated==expected);
+
+        // A result which cannot fit within the budget is rejected.
+        auto is_rejected = false;
+        try {
+            spill.memory_budget = 16;
+            solve_sorted<Solution::fast>(rectangles, [](Rectangle const&, RectangleSequence const&) {}, spill);
+        }
+        catch (std::length_error const&) {
+            is_rejected = true;
+        }
+        TEST_ASSERT(is_rejected);
+    }
 
     ////////////////////////////////////////////////////////////////////////////////
     // complete test suite for a given solution
@@ -674,13 +1906,26 @@ namespace {
         test_four_regression1<solution>();
         test_four_regression2<solution>();
         test_example<solution>();
+        test_visitor<solution>();
+        test_compact<solution>();
+        test_arena<solution>();
     }
 }
 
 int main()
 {
+    test_flat_map();
+    test_radix_sort(200, 1000);
+    test_transitions<intersections::Axis::horizontal>(20, 50, Rectangle{-50, -50, 100, 100});
+    test_transitions<intersections::Axis::vertical>(20, 50, Rectangle{-50, -50, 100, 100});
+    test_bitset(2000);
+
     test_hand_crafted<Solution::fast>();
     test_hand_crafted<Solution::simple>();
+    test_hand_crafted<Solution::fast_parallel>();
+    test_hand_crafted<Solution::tiled>();
+    test_hand_crafted<Solution::cliques>();
+    test_hand_crafted<Solution::grid>();
 
     puts("\nTesting fast solution:");
     test_heavy<Solution::fast>(1000, Interval{0, 10}, Interval{50, 50});
@@ -688,12 +1933,38 @@ int main()
     puts("\nTesting simple solution:");
     test_heavy<Solution::simple>(1000, Interval{0, 10}, Interval{50, 50});
 
-    puts("\nGenerating simple graph data:");
-    generate_data<Solution::simple>(5);
-
-    puts("\nGenerating fast graph data:");
-    generate_data<Solution::fast>(9);
-
-    // the previous test never passes due to an out-of-memory condition
-    puts("\nCongratulations, you have more RAM than me!");
+    test_agreement<Solution::fast, Solution::simple>(100, 16, Rectangle{0, 0, 20, 20});
+    test_agreement<Solution::fast, Solution::cliques>(100, 100, Rectangle{0, 0, 20, 20});
+    test_agreement<Solution::fast, Solution::grid>(100, 100, Rectangle{0, 0, 20, 20});
+    test_visit_order<Solution::fast, Solution::fast_parallel>(20, 100, Rectangle{0, 0, 50, 50});
+    test_options<Solution::fast>(20, 30, Rectangle{0, 0, 20, 20});
+    test_options<Solution::simple>(20, 30, Rectangle{0, 0, 20, 20});
+    test_options<Solution::fast_parallel>(20, 30, Rectangle{0, 0, 20, 20});
+    test_options<Solution::tiled>(20, 30, Rectangle{0, 0, 20, 20});
+    test_options<Solution::cliques>(20, 30, Rectangle{0, 0, 20, 20});
+    test_options<Solution::grid>(20, 30, Rectangle{0, 0, 20, 20});
+    test_stats<Solution::fast>(100, Rectangle{0, 0, 50, 50});
+    test_stats<Solution::simple>(20, Rectangle{0, 0, 50, 50});
+    test_stats<Solution::fast_parallel>(100, Rectangle{0, 0, 50, 50});
+    test_stats<Solution::tiled>(100, Rectangle{0, 0, 50, 50});
+    test_stats<Solution::cliques>(100, Rectangle{0, 0, 50, 50});
+    test_stats<Solution::grid>(100, Rectangle{0, 0, 50, 50});
+    test_tiled(10, 3000, 100);
+    test_parallel_for(100, 4);
+    test_parallel_for_ordered(100, 4, 3);
+    test_parallel_for_ordered(100, 1, 1);
+    test_rectangle_batch(200, Rectangle{-50, -50, 100, 100});
+    test_pairs(100, 100, Rectangle{-50, -50, 100, 100});
+    test_max_depth(100, 16, Rectangle{-10, -10, 30, 30});
+    test_area_by_depth(10, 3000, 300);
+    test_coverage_area();
+    test_coverage_random(6, 5000, 100, 40000);
+    test_incremental(200, 40, Rectangle{0, 0, 100, 100});
+    test_rtree(20, 2000, Rectangle{-100, -100, 1000, 1000});
+    test_grid_budget(4000);
+    test_cliques_budget(50000);
+    test_automatic(20, 100);
+    test_spill(100, Rectangle{0, 0, 100, 100});
+    test_rectangle_file(1000);
+    test_rectangles_handler();
 }
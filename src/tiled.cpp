@@ -0,0 +1,234 @@
+/// \file
+/// \brief defines intersections::solve<Solution::tiled>
+
+#include <intersections.h>
+
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using namespace intersections;
+
+namespace {
+    using Index = std::uint32_t;
+
+    // the number of rectangles to aim for in each tile
+    constexpr auto rectangles_per_tile = 256.;
+
+    // tiles are no smaller than this many times the mean size of the rectangles
+    // so that few rectangles must be solved in more than one tile
+    constexpr auto min_tile_extents = 4.;
+
+    // how many solved tiles may await report for each thread;
+    // bounds the memory held by results while keeping threads busy when one tile is slow
+    constexpr auto pending_tiles_per_thread = 2;
+
+    // a uniform grid of tiles which covers every rectangle
+    class Grid {
+    public:
+        // tile size is chosen from the number, size and spread of the rectangles
+        explicit Grid(Rectangles const& rectangles)
+        {
+            assert(!rectangles.empty());
+
+            auto bounds = rectangles.front();
+            auto total_width = 0.;
+            auto total_height = 0.;
+            for (auto const& rectangle : rectangles) {
+                bounds = Rectangle::from_intervals(
+                        Interval{std::min(bounds.interval(Axis::horizontal).start,
+                                          rectangle.interval(Axis::horizontal).start),
+                                 std::max(bounds.interval(Axis::horizontal).end,
+                                          rectangle.interval(Axis::horizontal).end)},
+                        Interval{std::min(bounds.interval(Axis::vertical).start,
+                                          rectangle.interval(Axis::vertical).start),
+                                 std::max(bounds.interval(Axis::vertical).end,
+                                          rectangle.interval(Axis::vertical).end)});
+                total_width += rectangle.w();
+                total_height += rectangle.h();
+            }
+            x = bounds.interval(Axis::horizontal).start;
+            y = bounds.interval(Axis::vertical).start;
+
+            // Divide the bounds into tiles holding rectangles_per_tile rectangles on average,
+            // which are square unless the bounds are too narrow
+            // or the rectangles are too large for tiles of that size.
+            auto const width = double(bounds.interval(Axis::horizontal).end)-x;
+            auto const height = double(bounds.interval(Axis::vertical).end)-y;
+            auto const num_tiles = std::max(1., double(rectangles.size())/rectangles_per_tile);
+            auto const tile_area = width*height/num_tiles;
+            auto const mean_width = total_width/double(rectangles.size());
+            auto const mean_height = total_height/double(rectangles.size());
+            auto const ideal_width = std::max(std::sqrt(tile_area), min_tile_extents*mean_width);
+            tile_width = std::int64_t(std::min(width, ideal_width));
+            auto const ideal_height = std::max(tile_area/double(tile_width), min_tile_extents*mean_height);
+            tile_height = std::int64_t(std::min(height, ideal_height));
+            num_columns = column(bounds.interval(Axis::horizontal).end-1)+1;
+            num_rows = row(bounds.interval(Axis::vertical).end-1)+1;
+        }
+
+        int num_tiles() const noexcept
+        {
+            return num_columns*num_rows;
+        }
+
+        // returns the tile which contains the given point
+        int tile(int const point_x, int const point_y) const noexcept
+        {
+            return row(point_y)*num_columns+column(point_x);
+        }
+
+        // call function with each tile which rectangle overlaps
+        template<typename Function>
+        void for_each_tile(Rectangle const& rectangle, Function function) const
+        {
+            auto const first_column = column(rectangle.interval(Axis::horizontal).start);
+            auto const last_column = column(rectangle.interval(Axis::horizontal).end-1);
+            auto const first_row = row(rectangle.interval(Axis::vertical).start);
+            auto const last_row = row(rectangle.interval(Axis::vertical).end-1);
+            for (auto tile_row = first_row; tile_row<=last_row; ++tile_row) {
+                for (auto tile_column = first_column; tile_column<=last_column; ++tile_column) {
+                    function(tile_row*num_columns+tile_column);
+                }
+            }
+        }
+
+    private:
+        int column(int const position) const noexcept
+        {
+            return int((std::int64_t(position)-x)/tile_width);
+        }
+
+        int row(int const position) const noexcept
+        {
+            return int((std::int64_t(position)-y)/tile_height);
+        }
+
+        // the corner of the first tile
+        int x;
+        int y;
+
+        std::int64_t tile_width;
+        std::int64_t tile_height;
+        int num_columns;
+        int num_rows;
+    };
+
+    // the results of solving a single tile;
+    // allocated from the heap as they outlive the working memory of the tile until they are reported
+    struct Results {
+        std::vector<Rectangle> overlaps;
+
+        // ends[n] is the end of the constituents of overlaps[n]
+        std::vector<std::size_t> ends;
+
+        RectangleSequence constituents;
+    };
+}
+
+namespace intersections {
+    template<>
+    void solve<Solution::tiled>(
+            Rectangles const& rectangles, Visitor const& visitor, SolveOptions const& options, Arena& arena)
+    {
+        assert(std::all_of(std::begin(rectangles), std::end(rectangles), is_positive));
+        assert(options.min_constituents>=2);
+        if (rectangles.empty()) {
+            return;
+        }
+
+        SolveRecorder recorder(options.stats, arena);
+
+        // Give each tile the rectangles which overlap it, in input order.
+        auto const grid = Grid(rectangles);
+        std::vector<std::vector<Index>> tile_rectangles(grid.num_tiles());
+        for (auto index = Index{0}; index!=rectangles.size(); ++index) {
+            grid.for_each_tile(rectangles[index], [&](int const tile) {
+                tile_rectangles[tile].push_back(index);
+            });
+        }
+
+        // Every constituent of an overlap contains its top-left corner
+        // so the tile which contains the corner has every constituent
+        // and solving that tile alone finds the overlap.
+        // Each tile solves its rectangles but only keeps the overlaps whose corners it contains.
+        // Tiles are solved in parallel and reported in turn as soon as they finish;
+        // reporting is timed as collection while the time spent waiting for tiles is timed as sweeping.
+
+        // stats are not thread-safe so each tile counts separately
+        std::vector<SolveStats> tile_stats(options.stats ? grid.num_tiles() : 0);
+
+        Arena::Scope const scope(&arena);
+        RectangleSequence constituents(&arena);
+        constituents.reserve(rectangles.size());
+        auto num_results = std::size_t{0};
+        auto const solve_tile = [&](int const tile) {
+            Results tile_results;
+            auto const& indices = tile_rectangles[tile];
+            if (indices.size()<options.min_constituents) {
+                return tile_results;
+            }
+
+            Rectangles tile_set;
+            tile_set.reserve(indices.size());
+            for (auto const index : indices) {
+                tile_set.push_back(rectangles[index]);
+            }
+
+            // other tiles' overlaps must not count towards the limit
+            auto tile_options = options;
+            tile_options.max_results = std::numeric_limits<std::size_t>::max();
+            tile_options.stats = options.stats ? &tile_stats[tile] : nullptr;
+
+            // arena is not thread-safe so each tile has its own working memory
+            Arena tile_arena;
+            auto const tile_first = tile_set.data();
+            solve<Solution::fast>(
+                    tile_set, [&](Rectangle const& overlap, RectangleSequence const& constituents) {
+                        auto const& horizontal = overlap.interval(Axis::horizontal);
+                        auto const& vertical = overlap.interval(Axis::vertical);
+                        if (grid.tile(horizontal.start, vertical.start)!=tile
+                                || tile_results.overlaps.size()>=options.max_results) {
+                            return;
+                        }
+
+                        tile_results.overlaps.push_back(overlap);
+                        for (auto const constituent : constituents) {
+                            tile_results.constituents.push_back(&rectangles[indices[constituent-tile_first]]);
+                        }
+                        tile_results.ends.push_back(tile_results.constituents.size());
+                    }, tile_options, tile_arena);
+            return tile_results;
+        };
+        auto const report_tile = [&](int, Results const& tile_results) {
+            recorder.begin(&SolveStats::collect_seconds);
+            auto constituents_begin = std::begin(tile_results.constituents);
+            for (auto n = std::size_t{0}; n!=tile_results.overlaps.size(); ++n, ++num_results) {
+                if (num_results>=options.max_results) {
+                    break;
+                }
+
+                auto const constituents_end = std::begin(tile_results.constituents)+tile_results.ends[n];
+                constituents.assign(constituents_begin, constituents_end);
+                visitor(tile_results.overlaps[n], constituents);
+                constituents_begin = constituents_end;
+            }
+            recorder.begin(&SolveStats::sweep_seconds);
+            return num_results<options.max_results;
+        };
+
+        // no more tiles are solved once the limit is reached
+        recorder.begin(&SolveStats::sweep_seconds);
+        auto const num_threads = default_num_threads();
+        parallel_for_ordered(
+                grid.num_tiles(), num_threads, num_threads*pending_tiles_per_thread, solve_tile, report_tile);
+
+        // The tiles' timings overlap so only their counts are added.
+        for (auto const& stats : tile_stats) {
+            options.stats->counts += stats.counts;
+        }
+    }
+}
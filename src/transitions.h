@@ -5,10 +5,14 @@
 #ifndef INTERSECTIONS_TRANSITIONS_H
 #define INTERSECTIONS_TRANSITIONS_H
 
+#include <arena.h>
 #include <rectangle.h>
 
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <map>
-#include <unordered_set>
+#include <vector>
 
 // enable prohibitively slow asserts
 //#define THOROUGH_ASSERTS
@@ -20,47 +24,239 @@
 #endif
 
 namespace intersections {
+    // the edges of a rectangle along an axis;
+    // at a given position, ending edges are ordered before starting edges
+    enum class Edge {
+        ending,
+        starting
+    };
+
     // at a given horizontal or vertical position, these rectangles start or end
-    struct TransitionMapped {
-        using Set = std::unordered_set<Rectangle const*>;
+    struct Step {
+        // a contiguous sequence of rectangles
+        struct Range {
+            Rectangle const* const* first;
+            Rectangle const* const* last;
+
+            constexpr auto begin() const noexcept { return first; }
+
+            constexpr auto end() const noexcept { return last; }
+
+            constexpr auto empty() const noexcept { return first==last; }
+
+            constexpr auto size() const noexcept { return std::size_t(last-first); }
+        };
+
+        int position;
 
-        // the set of rectangles which end at this position
-        Set ending;
+        // the rectangles which end at this position
+        Range ending;
 
-        // the set of rectangles which start at this position
-        Set starting;
+        // the rectangles which start at this position
+        Range starting;
     };
 
-    // maps out all of the positions along an axis where a Rectangle begins or ends
+    // stable sort of values by keys using least-significant-digit radix sort;
+    // passes over bytes which are the same in every key are skipped;
+    // working memory is allocated in the same way as keys
+    inline void radix_sort(ArenaVector<std::uint64_t>& keys, ArenaVector<Rectangle const*>& values)
+    {
+        assert(keys.size()==values.size());
+        auto const size = keys.size();
+        auto const arena = keys.get_allocator().arena();
+
+        // count occurrences of each value of each byte in a single pass
+        constexpr auto num_bytes = int(sizeof(std::uint64_t));
+        ArenaVector<std::size_t> histograms(num_bytes*256, arena);
+        for (auto const key : keys) {
+            for (auto byte = 0; byte!=num_bytes; ++byte) {
+                ++histograms[byte*256+((key >> (byte*8)) & 0xff)];
+            }
+        }
+
+        ArenaVector<std::uint64_t> sorted_keys(size, arena);
+        ArenaVector<Rectangle const*> sorted_values(size, arena);
+        for (auto byte = 0; byte!=num_bytes; ++byte) {
+            auto const offsets = histograms.data()+byte*256;
+            if (std::any_of(offsets, offsets+256, [size](auto count) { return count==size; })) {
+                continue;
+            }
+
+            auto offset = std::size_t{0};
+            for (auto digit = 0; digit!=256; ++digit) {
+                auto const count = offsets[digit];
+                offsets[digit] = offset;
+                offset += count;
+            }
+
+            auto const shift = byte*8;
+            for (auto n = std::size_t{0}; n!=size; ++n) {
+                auto const destination = offsets[(keys[n] >> shift) & 0xff]++;
+                sorted_keys[destination] = keys[n];
+                sorted_values[destination] = values[n];
+            }
+
+            keys.swap(sorted_keys);
+            values.swap(sorted_values);
+        }
+    }
+
+    // returns the address of a rectangle given either the rectangle or its address
+    inline Rectangle const* address_of(Rectangle const& rectangle) noexcept
+    {
+        return &rectangle;
+    }
+
+    inline Rectangle const* address_of(Rectangle const* rectangle) noexcept
+    {
+        return rectangle;
+    }
+
+    // maps out all of the positions along an axis where a Rectangle begins or ends;
+    // stored as a sequence of edges, sorted by position, so that it is compact and cheap to copy;
+    // memory is allocated from an optional Arena which is shared by copies
     template<Axis axis>
     class Transitions {
     public:
-        Transitions() = default;
+        // the axis along which positions are measured
+        static constexpr Axis transition_axis = axis;
+
+        // iterates over the positions at which rectangles start or end
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Step;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Step const*;
+            using reference = Step const&;
+
+            const_iterator() = default;
+
+            const_iterator(Transitions const& transitions, std::size_t first) noexcept
+                    :transitions(&transitions)
+            {
+                seek(first);
+            }
 
-        Transitions(Transitions const&) = default;
+            reference operator*() const noexcept
+            {
+                return step;
+            }
 
-        Transitions(Transitions&& that)
+            pointer operator->() const noexcept
+            {
+                return &step;
+            }
+
+            const_iterator& operator++() noexcept
+            {
+                seek(last);
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept
+            {
+                auto const previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return lhs.first==rhs.first;
+            }
+
+            friend bool operator!=(const_iterator const& lhs, const_iterator const& rhs) noexcept
+            {
+                return !(lhs==rhs);
+            }
+
+        private:
+            // find the edges at the position of the edge at index, first
+            void seek(std::size_t const position_first) noexcept
+            {
+                auto const& keys = transitions->keys;
+                auto const size = keys.size();
+
+                first = position_first;
+                last = position_first;
+                if (first==size) {
+                    return;
+                }
+
+                auto const position = position_of(keys[first]);
+                auto middle = first;
+                while (middle!=size && keys[middle]==make_key(position, Edge::ending)) {
+                    ++middle;
+                }
+                last = middle;
+                while (last!=size && keys[last]==make_key(position, Edge::starting)) {
+                    ++last;
+                }
+
+                auto const rectangles = transitions->rectangles.data();
+                step = Step{
+                        position,
+                        Step::Range{rectangles+first, rectangles+middle},
+                        Step::Range{rectangles+middle, rectangles+last}};
+            }
+
+            Transitions const* transitions = nullptr;
+
+            // the edges of the current step are in [first, last)
+            std::size_t first = 0;
+            std::size_t last = 0;
+
+            Step step{};
+        };
+
+        Transitions() = default;
+
+        explicit Transitions(Arena* arena) noexcept
+                :keys(arena), rectangles(arena)
         {
-            using std::swap;
-            swap(this->steps, that.steps);
-            swap(this->num_rectangles, that.num_rectangles);
         }
 
-        Transitions& operator=(Transitions const&) = default;
+        // bulk-load the edges of the given rectangles, or pointers to rectangles, which are in order of address
+        template<typename RectangleIterator>
+        Transitions(RectangleIterator const first, RectangleIterator const last, Arena* arena = nullptr)
+                :keys(arena), rectangles(arena)
+        {
+            auto const num_rectangles = std::distance(first, last);
+            keys.reserve(num_rectangles*2);
+            rectangles.reserve(num_rectangles*2);
+
+            // add edges in input order; radix sort is stable so input order is preserved between equal keys
+            for (auto edge : {Edge::ending, Edge::starting}) {
+                for (auto iterator = first; iterator!=last; ++iterator) {
+                    auto const rectangle = address_of(*iterator);
+                    auto const& interval = rectangle->interval(axis);
+                    keys.push_back(make_key((edge==Edge::starting) ? interval.start : interval.end, edge));
+                    rectangles.push_back(rectangle);
+                }
+            }
+            radix_sort(keys, rectangles);
 
-        Transitions& operator=(Transitions&& that)
+            AXIOM(valid());
+        }
+
+        Transitions(Transitions const& that)
+                :keys(that.keys, that.keys.get_allocator()), rectangles(that.rectangles, that.rectangles.get_allocator())
         {
-            using std::swap;
-            swap(this->steps, that.steps);
-            swap(this->num_rectangles, that.num_rectangles);
-            return *this;
         }
 
+        Transitions& operator=(Transitions const&) = default;
+
         ~Transitions()
         {
             assert(valid());
         }
 
+        Arena* arena() const noexcept
+        {
+            return keys.get_allocator().arena();
+        }
+
         auto empty() const noexcept
         {
             return size()==0;
@@ -68,36 +264,42 @@ namespace intersections {
 
         auto size() const noexcept
         {
-            return num_rectangles;
+            return int(keys.size()/2);
+        }
+
+        // the range from the first position to the last; must not be empty
+        Interval extent() const noexcept
+        {
+            assert(!empty());
+            return Interval{position_of(keys.front()), position_of(keys.back())};
         }
 
         auto begin() const noexcept
         {
-            return std::begin(steps);
+            return const_iterator(*this, 0);
         }
 
         auto end() const noexcept
         {
-            return std::end(steps);
+            return const_iterator(*this, keys.size());
         }
 
         void clear() noexcept
         {
-            steps.clear();
-            num_rectangles = 0;
+            keys.clear();
+            rectangles.clear();
         }
 
         void insert(Rectangle const* rectangle)
         {
             AXIOM(valid());
 
-            auto starting_insert_result = steps[rectangle->interval(axis).start].starting.insert(rectangle);
-            auto ending_insert_result = steps[rectangle->interval(axis).end].ending.insert(rectangle);
+            auto starting_insert_result = insert(make_key(rectangle->interval(axis).start, Edge::starting), rectangle);
+            auto ending_insert_result = insert(make_key(rectangle->interval(axis).end, Edge::ending), rectangle);
 
-            if (starting_insert_result.second!=ending_insert_result.second) {
+            if (starting_insert_result!=ending_insert_result) {
                 assert(false);
             }
-            num_rectangles += starting_insert_result.second;
 
             AXIOM(valid());
         }
@@ -106,83 +308,118 @@ namespace intersections {
         {
             AXIOM(valid());
 
-            auto starting_erase_result = steps[rectangle->interval(axis).start].starting.erase(rectangle);
-            auto ending_erase_result = steps[rectangle->interval(axis).end].ending.erase(rectangle);
+            auto starting_erase_result = erase(make_key(rectangle->interval(axis).start, Edge::starting), rectangle);
+            auto ending_erase_result = erase(make_key(rectangle->interval(axis).end, Edge::ending), rectangle);
 
             if (starting_erase_result!=ending_erase_result) {
                 assert(false);
             }
-            num_rectangles -= int(starting_erase_result);
 
             AXIOM(valid());
         }
 
     private:
-        // returns true iff class invariants hold
-        auto valid() const noexcept
+        using Key = std::uint64_t;
+
+        // keys sort by position and then by edge
+        static constexpr Key make_key(int position, Edge edge) noexcept
         {
-            std::map<Rectangle const*, int> rectangle_edge_counts;
-            std::map<Rectangle const*, int> rectangle_counts;
+            return (Key(std::uint32_t(position) ^ 0x80000000u) << 1) | Key(edge);
+        }
 
-            for (auto const& step : steps) {
-                for (auto const starting_rectangle : step.second.starting) {
-                    ++rectangle_edge_counts[starting_rectangle];
+        static constexpr int position_of(Key key) noexcept
+        {
+            return int(std::uint32_t(key >> 1) ^ 0x80000000u);
+        }
 
-                    auto& rectangle_count = rectangle_counts[starting_rectangle];
-                    ++rectangle_count;
-                    if (rectangle_count!=1) {
-                        return false;
-                    }
+        // returns the index of the first edge not ordered before the given edge
+        std::size_t lower_bound(Key const key, Rectangle const* rectangle) const noexcept
+        {
+            auto first = std::size_t{0};
+            auto count = keys.size();
+            while (count>0) {
+                auto const half = count/2;
+                auto const middle = first+half;
+                if (keys[middle]<key
+                        || (keys[middle]==key && std::less<Rectangle const*>{}(rectangles[middle], rectangle))) {
+                    first = middle+1;
+                    count -= half+1;
                 }
-
-                for (auto const ending_rectangle : step.second.ending) {
-                    ++rectangle_edge_counts[ending_rectangle];
-
-                    auto& rectangle_count = rectangle_counts[ending_rectangle];
-                    --rectangle_count;
-                    if (rectangle_count!=0) {
-                        return false;
-                    }
+                else {
+                    count = half;
                 }
             }
+            return first;
+        }
 
-            if (rectangle_edge_counts.size()!=rectangle_counts.size()) {
+        // returns true iff the edge was not already present
+        bool insert(Key const key, Rectangle const* rectangle)
+        {
+            auto const index = lower_bound(key, rectangle);
+            if (index!=keys.size() && keys[index]==key && rectangles[index]==rectangle) {
                 return false;
             }
 
-            if (num_rectangles!=int(rectangle_counts.size())) {
+            keys.insert(std::begin(keys)+index, key);
+            rectangles.insert(std::begin(rectangles)+index, rectangle);
+            return true;
+        }
+
+        // returns true iff the edge was present
+        bool erase(Key const key, Rectangle const* rectangle)
+        {
+            auto const index = lower_bound(key, rectangle);
+            if (index==keys.size() || keys[index]!=key || rectangles[index]!=rectangle) {
                 return false;
             }
 
-            if (!std::all_of(
-                    std::begin(rectangle_edge_counts), std::end(rectangle_edge_counts), [](auto rectangle_edge_count) {
-                        return rectangle_edge_count.second==2;
-                    })) {
+            keys.erase(std::begin(keys)+index);
+            rectangles.erase(std::begin(rectangles)+index);
+            return true;
+        }
+
+        // returns true iff class invariants hold
+        auto valid() const noexcept
+        {
+            if (keys.size()!=rectangles.size()) {
                 return false;
             }
 
-            if (!std::all_of(
-                    std::begin(rectangle_counts), std::end(rectangle_counts), [](auto rectangle_count) {
-                        return rectangle_count.second==0;
-                    })) {
-                return false;
+            for (auto n = std::size_t{1}; n<keys.size(); ++n) {
+                if (keys[n]<keys[n-1]
+                        || (keys[n]==keys[n-1] && !std::less<Rectangle const*>{}(rectangles[n-1], rectangles[n]))) {
+                    return false;
+                }
             }
 
-            return true;
+            // each rectangle has one ending and one starting edge at its bounds
+            std::map<Rectangle const*, int> rectangle_edge_counts;
+            for (auto n = std::size_t{0}; n!=keys.size(); ++n) {
+                auto const rectangle = rectangles[n];
+                auto const& interval = rectangle->interval(axis);
+                auto const edge = Edge(keys[n] & 1);
+                auto const position = position_of(keys[n]);
+                if (position!=((edge==Edge::starting) ? interval.start : interval.end)) {
+                    return false;
+                }
+
+                rectangle_edge_counts[rectangle] += (edge==Edge::starting) ? 1 : 2;
+            }
+
+            return std::all_of(
+                    std::begin(rectangle_edge_counts), std::end(rectangle_edge_counts), [](auto rectangle_edge_count) {
+                        return rectangle_edge_count.second==3;
+                    });
         }
 
-        std::map<int, TransitionMapped> steps;
-        int num_rectangles = 0;
+        ArenaVector<Key> keys;
+        ArenaVector<Rectangle const*> rectangles;
     };
 
     template<Axis axis>
-    auto make_transitions(Rectangles const& rectangles)
+    auto make_transitions(Rectangles const& rectangles, Arena* arena = nullptr)
     {
-        Transitions<axis> edges;
-        for (auto const& rectangle : rectangles) {
-            edges.insert(&rectangle);
-        }
-        return edges;
+        return Transitions<axis>(std::begin(rectangles), std::end(rectangles), arena);
     }
 }
 